@@ -24,8 +24,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdio.h>
 #include "raylib.h"
 #include "scene.h"
+#include "utils/random.h"
+#include "utils/workers.h"
 
-bool    game_init(int width, int height);
+bool    game_init(int width, int height, bool headless);
 void    game_deinit(void);
 
 void    game_register_scene(scene_t scene);
@@ -36,11 +38,39 @@ bool    game_is_running(void);
 void    game_end_run(void);
 void    game_run(void);
 
+// Stop game_run() after the given number of ticks, zero to never stop
+void    game_set_tick_limit(unsigned long limit);
+
+void    game_set_tick_rate(int rate);
+int     game_tick_rate(void);
+float   game_tick_delta(void);
+float   game_tick_alpha(void);
+
+unsigned long game_ticks(void);
+double        game_time(void);
+
+// Seed of the world, by default the time when the game started, setting it
+// restarts all random streams.
+void      game_set_seed(unsigned seed);
+unsigned  game_seed(void);
+random_t *game_random(random_stream_t stream);
+
+bool    game_headless(void);
+
 int     game_width(void);
 int     game_height(void);
 
 FILE   *game_file(const char *mode);
 
+// Write the whole save again on a temporary file, the commit replaces the save
+// with it only when all of it was written, so a failed write keeps the old one.
+FILE   *game_file_replace(void);
+bool    game_file_commit(FILE *file);
+void    game_set_save_path(const char *path);
+
+void       game_set_threads(unsigned threads);
+workers_t *game_workers(void);
+
 Vector2 game_virtual_mouse(void);
 Vector2 game_virtual_touch(int touch_number);
 
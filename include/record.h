@@ -0,0 +1,65 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "raylib.h"
+
+typedef enum {
+    RECORD_OFF,
+    RECORD_WRITE,
+    RECORD_REPLAY,
+} record_mode_t;
+
+// The input consumed by one tick of the gameplay, it's what is recorded
+// instead of the raw keys, mouse and touches, so the same stream replays on
+// any platform.
+typedef struct {
+    Vector2 direction;
+
+    bool attack_pressed;
+    bool attack_released;
+
+    bool mouse_pressed;
+    Vector2 mouse;
+} record_input_t;
+
+// Open the file to write a new recording with the given seed and tick rate, or
+// to replay one, in this case the seed and the tick rate are read from it.
+bool          record_open(const char *filename, record_mode_t mode,
+    unsigned seed, int tick_rate);
+void          record_close(void);
+
+record_mode_t record_mode(void);
+unsigned      record_seed(void);
+int           record_tick_rate(void);
+
+// Called at the start of each tick, writes the input when recording or
+// replaces it when replaying, returns false when the replay is over.
+bool          record_input(record_input_t *input);
+
+// Called at the end of each tick with the world checksum, returns false when
+// the replay diverges from the recording.
+bool          record_checksum(uint32_t checksum);
+bool          record_diverged(void);
+
+#endif // !RECORD_H
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef SCENE_H
 #define SCENE_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define SCENE_IMPORT(scene)                                                    \
@@ -27,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
     extern void          scene##_deinit(scene_data_t *data);                   \
                                                                                \
     extern void          scene##_update(scene_data_t *data);                   \
+    extern void          scene##_tick(scene_data_t *data);                     \
     extern void          scene##_draw(scene_data_t *data)
 
 #define SCENE(scene) (scene_t) {                                               \
@@ -34,6 +36,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
         .deinit = scene##_deinit,                                              \
                                                                                \
         .update = scene##_update,                                              \
+        .tick   = NULL,                                                        \
+        .draw   = scene##_draw,                                                \
+                                                                               \
+        .name = #scene                                                         \
+    }
+
+// Scene that also has a simulation running at the fixed tick rate
+#define SCENE_TICKED(scene) (scene_t) {                                        \
+        .init   = scene##_init,                                                \
+        .deinit = scene##_deinit,                                              \
+                                                                               \
+        .update = scene##_update,                                              \
+        .tick   = scene##_tick,                                                \
         .draw   = scene##_draw,                                                \
                                                                                \
         .name = #scene                                                         \
@@ -45,11 +60,22 @@ typedef struct {
     scene_data_t *(* init)(void);
     void          (* deinit)(scene_data_t *data);
 
+    // Called once for each frame, it's where the input is sampled
     void          (* update)(scene_data_t *data);
+
+    // Called zero or more times for each frame, one time for each elapsed
+    // tick of game_tick_delta() seconds
+    void          (* tick)(scene_data_t *data);
+
     void          (* draw)(scene_data_t *data);
 
     const char *name;
 } scene_t;
 
+// The genmap scene generates the world on its own thread, the scenes before it
+// can start the generation and show how much of it is done.
+void  genmap_start(void);
+float genmap_progress(void);
+
 #endif // !SCENE_H
 
@@ -0,0 +1,53 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+#include <stdio.h>
+#include "raylib.h"
+
+// Polynomial approximations of the trigonometric functions on float, the
+// bounds are the maximum absolute errors against libm and
+// fastmath_benchmark() measures them again. The batches give the same results
+// of the scalar functions.
+
+// Angle of (x, y) on [-pi, pi], 0 for (0, 0). Error below 2.5e-6 rad.
+float   fastmath_atan2(float y, float x);
+
+// Same as vec2ang(), the angle of (x, y) on [0, 2pi)
+float   fastmath_angle(float x, float y);
+
+// Error below 2e-7 while |angle| <= 2pi, the range reduction loses precision
+// on larger angles and it grows to 1e-5 at 64pi.
+void    fastmath_sincos(float angle, float *sine, float *cosine);
+
+// Unit vector of the direction, an entity that uses its direction more than
+// once on a frame converts it only once.
+Vector2 fastmath_unit(float angle);
+
+void    fastmath_angle_batch(const float *x, const float *y, float *angles,
+    unsigned count);
+void    fastmath_sincos_batch(const float *angles, float *sines,
+    float *cosines, unsigned count);
+
+// Time and error of each function against libm, on random inputs
+void    fastmath_benchmark(FILE *file);
+
+#endif // !FASTMATH_H
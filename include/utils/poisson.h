@@ -0,0 +1,46 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POISSON_H
+#define POISSON_H
+
+#include <stdbool.h>
+#include "raylib.h"
+#include "utils/random.h"
+
+// Number of candidates tried around each sample before it stops being active,
+// and on each empty cell of the grid to start the samples on it.
+#define POISSON_ATTEMPTS      16
+#define POISSON_SEED_ATTEMPTS 4
+
+// Pick cells of a width x height grid by the Bridson's algorithm, all of them
+// set on the mask (row major) and no two closer than the radius. The samples
+// are stored on a new array, in the order they were placed, and the number of
+// them is returned. Each one takes a constant number of tries, therefore, the
+// time grows with the number of samples and not with the size of the grid.
+unsigned poisson_sample(random_t *random, const bool *mask, int width,
+    int height, float radius, Vector2 **samples);
+
+// Same, but the new samples are also apart from the fixed ones, that can be
+// out of the grid (as the samples of the rows above it) and aren't returned.
+unsigned poisson_sample_around(random_t *random, const bool *mask, int width,
+    int height, float radius, const Vector2 *fixed, unsigned fixed_count,
+    Vector2 **samples);
+
+#endif // !POISSON_H
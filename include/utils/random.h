@@ -0,0 +1,65 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+// Independent streams of the game, each subsystem draws only from its own so
+// a change on how one uses the random numbers don't change the others.
+typedef enum {
+    RANDOM_STREAM_WORLDGEN,
+    RANDOM_STREAM_AI,
+    RANDOM_STREAM_COMBAT,
+    RANDOM_STREAM_SPAWNING,
+
+    RANDOM_STREAMS,
+} random_stream_t;
+
+// PCG32 (XSH RR), the increment selects the stream.
+typedef struct {
+    uint64_t state;
+    uint64_t increment;
+} random_t;
+
+void     random_seed(random_t *random, uint64_t seed, uint64_t stream);
+
+// Seed a new generator from the numbers of other, used to give each entity its
+// own generator.
+void     random_split(random_t *random, random_t *from);
+
+uint32_t random_next(random_t *random);
+
+// Uniform on [0, bound) and [min, max], without the modulo bias
+uint32_t random_bounded(random_t *random, uint32_t bound);
+int      random_range(random_t *random, int min, int max);
+
+// Uniform on [0, 1)
+float    random_float(random_t *random);
+double   random_double(random_t *random);
+
+// Same as calling random_next() delta times, in O(log delta)
+void     random_advance(random_t *random, uint64_t delta);
+
+// Same numbers of calling random_next() count times, but the generator runs
+// as independent lanes that are several times faster.
+void     random_fill(random_t *random, uint32_t *values, unsigned count);
+
+#endif // !RANDOM_H
@@ -0,0 +1,44 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Accumulated wall time of named sections of the main thread, the sections are
+// created on the first use and reported in that order. While disabled, that's
+// the default, stats_begin() and stats_end() do nothing.
+void   stats_enable(bool enable);
+bool   stats_enabled(void);
+
+void   stats_begin(const char *name);
+void   stats_end(const char *name);
+
+// Values sampled by name, like counts of each tick, reported apart from the
+// sections with their mean and maximum.
+void   stats_sample(const char *name, double value);
+
+// Monotonic wall clock, in seconds
+double stats_now(void);
+
+void   stats_print(FILE *file);
+
+#endif // !STATS_H
@@ -0,0 +1,99 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include <stdbool.h>
+
+// Hierarchical timer wheel on ticks. Each level has TIMERS_SLOTS slots, each
+// one TIMERS_SLOTS times longer than the ones of the level below, a timer is
+// kept on the level of how far it is and goes down as its tick approaches.
+// Starting and stopping are O(1), and a tick only touches the timers that
+// expire on it plus, once every TIMERS_SLOTS ticks, a slot of the levels above.
+#define TIMERS_LEVELS    4
+#define TIMERS_SLOT_BITS 6
+#define TIMERS_SLOTS     (1 << TIMERS_SLOT_BITS)
+
+// Farther timers are kept on the farthest tick, around 77 hours on 60 ticks
+// per second.
+#define TIMERS_MAX_TICKS ((1ul << (TIMERS_LEVELS * TIMERS_SLOT_BITS)) - 1)
+
+typedef void (* timers_callback_t)(void *data);
+
+// The handle of a timer that expired or was stopped is never reused, the
+// generation of its node changes.
+typedef struct {
+    unsigned index;
+    unsigned generation;
+} timers_handle_t;
+
+#define TIMERS_NONE ((timers_handle_t) { 0, 0 })
+
+typedef struct {
+    unsigned long expires;
+
+    timers_callback_t callback;
+    void             *data;
+
+    unsigned generation;
+
+    // Neighbors on the slot, or the next unused node
+    int previous;
+    int next;
+
+    // Slot on the levels, -1 while unused
+    int slot;
+} timers_node_t;
+
+typedef struct {
+    timers_node_t *nodes;
+    unsigned       nodes_count;
+    unsigned       nodes_capacity;
+
+    int unused;
+
+    // The timers of each slot on the order they were started, the last slot
+    // holds the ones expiring on the tick that is running.
+    struct {
+        int first;
+        int last;
+    } slots[TIMERS_LEVELS * TIMERS_SLOTS + 1];
+
+    // Next tick to run
+    unsigned long tick;
+} timers_t;
+
+void timers_create(timers_t *timers);
+void timers_destroy(timers_t *timers);
+
+// Run the callback with the data after the given number of ticks, at least
+// one. The callbacks can start and stop timers.
+timers_handle_t timers_start(timers_t *timers, unsigned long ticks,
+    timers_callback_t callback, void *data);
+
+// False when the timer already expired or was stopped
+bool timers_stop(timers_t *timers, timers_handle_t handle);
+bool timers_active(const timers_t *timers, timers_handle_t handle);
+
+// Run the timers that expire on the next tick, on the order they were started
+// when they were started on the same level.
+void timers_tick(timers_t *timers);
+
+#endif // !TIMERS_H
@@ -49,6 +49,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define max(x, y) ((x) > (y) ? (x) : (y))
 #define min(x, y) ((x) < (y) ? (x) : (y))
 
+#define lerp(from, to, amount) ((from) + ((to) - (from)) * (amount))
+
 #define dbg_point()                                                            \
     printf("FILE: %s\nFUNC: %s\nLINE: %u\n\n", __FILE__, __func__, __LINE__);
 
@@ -0,0 +1,41 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WORKERS_H
+#define WORKERS_H
+
+typedef struct workers workers_t;
+
+// Process the items [first, last), the worker number is always the same for
+// the same range so it can be used to index per worker buffers.
+typedef void (* workers_job_t)(void *context, unsigned worker,
+    unsigned first, unsigned last);
+
+workers_t *workers_create(unsigned count);
+void       workers_destroy(workers_t *workers);
+
+unsigned   workers_count(workers_t *workers);
+unsigned   workers_cpu_count(void);
+
+// Split the items in contiguous ranges, one for each worker, the calling
+// thread run the first range and only return when all ranges are done.
+void       workers_run(workers_t *workers, unsigned items, workers_job_t job,
+    void *context);
+
+#endif // !WORKERS_H
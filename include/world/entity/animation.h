@@ -0,0 +1,90 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <stdbool.h>
+#include "raylib.h"
+
+#define ANIMATION_MAX_CLIPS  8
+#define ANIMATION_MAX_FRAMES 16
+
+// Description of a clip on the table of a kind of entity. The frames are the
+// squares of the given size along the texture, from the left, each one shown
+// for the same time.
+typedef struct {
+    const char *texture;
+    float       size;
+    float       duration;
+
+    // The clips that don't loop stay on their last frame
+    bool loop;
+} animation_clip_info_t;
+
+typedef struct {
+    Texture texture;
+
+    // Source rectangle of each frame on the texture, and its duration in ticks
+    Rectangle frames[ANIMATION_MAX_FRAMES];
+    unsigned  durations[ANIMATION_MAX_FRAMES];
+    int       count;
+
+    bool loop;
+} animation_clip_t;
+
+// Clips shared by all the entities of a kind, built once
+typedef struct {
+    animation_clip_t clips[ANIMATION_MAX_CLIPS];
+    int              count;
+} animation_table_t;
+
+// Clip that an entity plays and where it is on it
+typedef struct {
+    int      clip;
+    int      current;
+    unsigned elapsed;
+
+    // Set while on the last frame, where the entities end the clips that
+    // don't loop.
+    bool last;
+
+    // Source rectangle of the current frame on the texture of the clip
+    Rectangle source;
+} animation_frame_t;
+
+// The textures must be loaded before
+void animation_table_create(animation_table_t *table,
+    const animation_clip_info_t *clips, int count);
+
+// Start the clip from its first frame
+void animation_play(const animation_table_t *table, animation_frame_t *frame,
+    int clip);
+
+// Advance the frame by one tick, a clip other than the one that was playing
+// starts from its first frame instead.
+void animation_advance(const animation_table_t *table,
+    animation_frame_t *frame, int clip);
+
+// Play the clip again from its first frame on the next advance
+#define animation_restart(frame) ((frame)->clip = -1)
+
+#define animation_texture(table, frame) ((table)->clips[(frame)->clip].texture)
+
+#endif // !ANIMATION_H
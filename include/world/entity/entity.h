@@ -20,8 +20,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef ENTITY_H
 #define ENTITY_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "raylib.h"
 #include "utils/list.h"
+#include "utils/random.h"
+#include "utils/timers.h"
+#include "utils/workers.h"
+#include "world/entity/animation.h"
+#include "world/map/clearance.h"
+#include "world/map/flowfield.h"
+#include "world/map/hpa.h"
 #include "world/map/map.h"
 #include "world/map/tile.h"
 
@@ -32,10 +41,61 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define ENTITY_SPRITE_SIZE    16.0
 
 #define ENTITY_FRAME_DELAY (120.0 / 1000.0)
+#define ENTITY_HIT_COOLDOWN (300.0 / 1000.0)
 
 typedef struct entity entity_t;
 typedef list(entity_t *) entity_list_t;
 
+// Hits are never applied directly by the update of other entity, they're
+// collected and applied after all entities are updated, in the order of the
+// entity that caused them.
+typedef struct {
+    unsigned source;
+    unsigned target;
+
+    float damage;
+    float direction;
+
+    // When set the hit don't take hearts while the target is on the hit
+    // cooldown, and starts the cooldown when it takes.
+    bool cooldown;
+
+    // When set the target turn around if it's facing the same side of the hit
+    // direction.
+    bool turn;
+} entity_hit_t;
+
+typedef list(entity_hit_t) entity_hit_list_t;
+
+typedef struct {
+    // Copy of all entities as they were before the update, in the same order
+    // of the entities list.
+    const entity_t *snapshot;
+    unsigned        count;
+
+    map_t *map;
+
+    // Walks to the tile of the player, shared by the entities that chase it
+    const flowfield_t *flow;
+
+    // Paths farther than the field, each entity keeps the one it walks
+    const hpa_t *hpa;
+
+    // Distance of the tiles to the obstacles, to steer away from them
+    const clearance_t *clearance;
+
+    entity_hit_list_t *hits;
+} entity_context_t;
+
+// Timers of an entity, each one with its own slot
+typedef enum {
+    ENTITY_TIMER_COOLDOWN,
+    ENTITY_TIMER_ACTION,
+
+    ENTITY_TIMERS,
+} entity_timer_t;
+
+// The states are also the clips on the animation tables
 typedef enum {
     ENTITY_STATE_SPAWN,
     ENTITY_STATE_MOVING,
@@ -48,32 +108,82 @@ struct entity {
     float   velocity;
     float   direction;
 
+    // Displacement wanted on the current tick, the entity_update() resolve it
+    // against the map after all entities are updated.
+    Vector2 motion;
+
+    // Position before the last tick, the drawing interpolates between it and
+    // the current position.
+    Vector2 previous_position;
+
     float damage_direction;
 
     float hearts;
     float max_hearts;
 
+    // Set by the hits that take hearts with cooldown, until it ends
+    bool hitted;
+
     float attack;
     float defense;
 
     entity_state_t state;
 
+    // Clips of the kind of the entity, the one of the state is advanced after
+    // all entities are updated.
+    const animation_table_t *animation;
+    animation_frame_t        frame;
+
+    // The decisions of the entities are spread over the ticks by the scheduler,
+    // on the other ticks the updates only keep the entities moving.
     struct {
-        int   current;
-        float delay;
-        int   max;
-    } frame;
+        // Set by the scheduler for the ticks on which the update can decide,
+        // to the ticks that the decision covers, so the chances of each tick
+        // can be scaled by it. Zero on the other ticks.
+        unsigned think;
+
+        // Set by the update while the entity reacts to the player, so it
+        // thinks on every tick as the near ones.
+        bool engaged;
+
+        // Ticks since the last decision
+        unsigned lag;
+    } ai;
+
+    // Handles of the timers running for the entity, TIMERS_NONE when none
+    timers_handle_t timers[ENTITY_TIMERS];
 
     unsigned spawner_id;
 
-    void (* update)(unsigned entity, entity_list_t *entities, map_t *map);
-    void (* draw)(entity_t *entity, Rectangle camera);
+    // Generators of the entity, split from the game streams when it's created,
+    // the update must use them so the result don't depend on the entities
+    // update order.
+    random_t ai_random;
+    random_t combat_random;
+
+    void (* update)(entity_t *entity, unsigned index, entity_context_t *context);
+    void (* draw)(entity_t *entity, Vector2 position, Rectangle camera);
     void (* destroy)(entity_t *entity);
 };
 
-void entity_update(entity_list_t *entities, map_t *map, Rectangle camera);
-void entity_draw(entity_list_t *entities, Rectangle camera);
+void entity_update(entity_list_t *entities, map_t *map, const hpa_t *hpa,
+    const clearance_t *clearance, Rectangle camera, workers_t *workers);
+void entity_draw(entity_list_t *entities, Rectangle camera, float alpha);
 void entity_destroy(entity_list_t *entities);
 
+// Hash of the simulation state of all entities, to compare runs tick by tick
+uint32_t entity_checksum(entity_list_t *entities);
+
+void entity_hit(entity_context_t *context, entity_hit_t hit);
+
+// Walk again to the player after a tile of the map changed
+void entity_map_changed(void);
+
+// Run the callback with the entity after the given time, rounded to the ticks
+// of entity_update(), replacing the timer running on the slot. The timers can't
+// be started inside of the updates, they run on the workers.
+void entity_timer_start(entity_t *entity, entity_timer_t timer, float seconds,
+    timers_callback_t callback);
+
 #endif // !ENTITY_H
 
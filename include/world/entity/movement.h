@@ -0,0 +1,94 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOVEMENT_H
+#define MOVEMENT_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "world/map/map.h"
+
+// Number of entities resolved at once by movement_resolve(), the remaining
+// ones (count % MOVEMENT_LANES) go through the scalar path.
+#if defined(__AVX2__)
+#define MOVEMENT_LANES 8
+#elif defined(__SSE2__) || defined(__ARM_NEON)
+#define MOVEMENT_LANES 4
+#else
+#define MOVEMENT_LANES 1
+#endif
+
+// Structure of arrays with the position and the displacement of each entity
+// that moves on this frame, the positions are overwritten by the resolved ones.
+typedef struct {
+    float *x;
+    float *y;
+
+    float *dx;
+    float *dy;
+
+    unsigned count;
+    unsigned capacity;
+} movement_batch_t;
+
+void movement_batch_create(movement_batch_t *batch);
+void movement_batch_destroy(movement_batch_t *batch);
+
+void movement_batch_add(movement_batch_t *batch, float x, float y,
+    float dx, float dy);
+
+#define movement_batch_empty(batch) ((batch)->count = 0)
+
+// Gap left between a box and the tile that stopped it
+#define MOVEMENT_SKIN 0.001f
+
+typedef struct {
+    // Fraction of the displacement walked until the hit, 1 without it
+    float time;
+
+    // Position of the box on the hit, a skin before the tiles
+    float x;
+    float y;
+
+    // Axes on which the box was stopped
+    bool blocked_x;
+    bool blocked_y;
+} movement_hit_t;
+
+// Integrate and resolve the collisions of the entities on the batch against
+// the map, with the boxes of the given size. The boxes are swept through the
+// tiles they cross, so they don't tunnel through thin obstacles, they stop on
+// the first tile that collides on any layer and slide along it. The tiles out
+// of the map collide.
+void movement_resolve(movement_batch_t *batch, map_t *map, float size);
+void movement_resolve_scalar(movement_batch_t *batch, unsigned first,
+    map_t *map, float size);
+
+// Sweep a box, from its top left corner and along the displacement, through
+// the tiles that it enters. False when none of them collides, the tiles that
+// the box already is on don't stop it.
+bool movement_sweep(map_t *map, float x, float y, float size, float dx,
+    float dy, movement_hit_t *hit);
+
+// Resolve random batches on a random map with movement_resolve() and with
+// movement_resolve_scalar(), false when any position isn't the same on both.
+// The lanes and the remaining entities are both on the batches.
+bool movement_check(FILE *file);
+
+#endif // !MOVEMENT_H
@@ -24,23 +24,31 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "raylib.h"
 #include "world/entity/entity.h"
 
+// State of a new player
+#define PLAYER_DEFAULT_VELOCITY 5
+#define PLAYER_DEFAULT_HEARTS   100
+#define PLAYER_DEFAULT_ATTACK   20
+#define PLAYER_DEFAULT_DEFENSE  20
+
+// Time the sword hits before the attack ends
+#define PLAYER_ATTACK_TIME (50.0 / 1000.0)
+
 typedef struct player {
     entity_t base;
 
     bool attacked;
-    float attacking;
-
-    struct {
-        Texture moving;
-        Texture damaging;
-        Texture idle;
-        Texture sword;
-    } spritesheet;
+    bool attacking;
+
+    // Drawn with the frame of the clip of the player
+    Texture sword;
 } player_t;
 
 player_t *player_create(Vector2 position);
 bool player_load(player_t *player);
 
+// Start an attack, outside of the entities update
+void player_attack(player_t *player);
+
 bool player_save(player_t *player);
 bool player_exists(void);
 
@@ -0,0 +1,57 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "world/entity/entity.h"
+
+// Decisions taken on each tick at most
+#define SCHEDULER_BUDGET 32
+
+// Distance to the player, in tiles, under which the entities think on every
+// tick. Farther, they think once for each multiple of it, up to the period.
+#define SCHEDULER_NEAR_RADIUS 6
+#define SCHEDULER_MAX_PERIOD  8
+
+typedef struct {
+    unsigned index;
+
+    // Ticks since the last decision, counting this one, and between the
+    // decisions of the entity
+    unsigned lag;
+    unsigned period;
+} scheduler_candidate_t;
+
+typedef struct {
+    scheduler_candidate_t *candidates;
+    unsigned               capacity;
+} scheduler_t;
+
+void scheduler_create(scheduler_t *scheduler);
+void scheduler_destroy(scheduler_t *scheduler);
+
+// Choose the entities that think on this tick, the due ones ordered by how
+// many periods they're behind and then the nearest, until the budget. So the
+// near entities go first, but the far ones aren't left behind forever. The
+// first entity is the player and always thinks. It only depends on the
+// entities, so the choice is the same on any run.
+void scheduler_update(scheduler_t *scheduler, entity_list_t *entities);
+
+#endif // !SCHEDULER_H
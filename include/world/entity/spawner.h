@@ -24,9 +24,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "raylib.h"
 #include "utils/list.h"
 #include "world/entity/entity.h"
+#include "world/map/clearance.h"
 
 #define SPAWNER_DISTANCE_RADIUS 20
 
+// Entities spawned around a new spawner
+#define SPAWNER_DEFAULT_MIN_ENTITIES 3
+#define SPAWNER_DEFAULT_MAX_ENTITIES 8
+#define SPAWNER_DEFAULT_RADIUS       3
+
 typedef struct {
     Vector2 position;
 
@@ -45,7 +51,10 @@ void spawner_create(spawner_list_t *spawners);
 bool spawner_load(spawner_list_t *spawners);
 void spawner_destroy(spawner_list_t *spawners);
 
-void spawner_update(spawner_list_t *spawners, entity_list_t *entities);
+// The entities are spawned on the center of tiles that don't collide, the
+// nearest one to the random point when it does.
+void spawner_update(spawner_list_t *spawners, entity_list_t *entities,
+    const clearance_t *clearance);
 
 void spawner_new(spawner_list_t *spawners, Vector2 point);
 
@@ -0,0 +1,68 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CLEARANCE_H
+#define CLEARANCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "world/map/map.h"
+
+// Distance of a step to the sides and on the diagonals, near to 1 and sqrt(2)
+#define CLEARANCE_SIDE     2
+#define CLEARANCE_DIAGONAL 3
+
+// The distances stop here, 16 tiles, so a change only reaches the tiles this
+// near to it.
+#define CLEARANCE_MAX 32
+
+// Distance of each tile to the nearest one that collides on any layer, the
+// tiles out of the map collide. It's the chamfer distance of the steps above,
+// made by one pass from the top left and one from the bottom right.
+typedef struct {
+    map_t *map;
+
+    // Distances by rows, 0 on the tiles that collide
+    uint8_t *distances;
+} clearance_t;
+
+void clearance_create(clearance_t *clearance, map_t *map);
+void clearance_destroy(clearance_t *clearance);
+
+// Make again the distances around a tile after it's changed by map_set_tile()
+void clearance_update(clearance_t *clearance, int x, int y);
+
+// Distance in tiles from a point to the nearest tile that collides, measured
+// from the tile of the point.
+float clearance_at(const clearance_t *clearance, float x, float y);
+
+// Nearest tile to a tile, on the squares around it up to the radius, with the
+// distance in tiles. It doesn't check if the tile can walk to it.
+bool  clearance_nearest(const clearance_t *clearance, int x, int y,
+    float distance, int radius, int *nearest_x, int *nearest_y);
+
+// Direction where the distance grows from the tile of a point, false when it
+// doesn't grow to any side.
+bool  clearance_away(const clearance_t *clearance, float x, float y,
+    float *direction);
+
+#define clearance_tile(clearance, x, y) \
+    ((clearance)->distances[(y) * (clearance)->map->width + (x)])
+
+#endif // !CLEARANCE_H
@@ -0,0 +1,75 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "world/map/map.h"
+
+// Tiles on each side of the target that the field covers
+#define FLOWFIELD_RADIUS 16
+
+#define FLOWFIELD_NONE      -1
+#define FLOWFIELD_UNREACHED UINT16_MAX
+
+// Shortest walks to a target tile from the tiles around it that don't collide
+// on any layer. It's a breadth first search from the target over a square
+// window, that moves on the 8 directions without cutting the corners of the
+// tiles that collide. The search is only made again when the target moves to
+// other tile, all the entities that follow it share the same one.
+typedef struct {
+    map_t *map;
+
+    int radius;
+    int size;
+
+    // Tile of the target and top left tile of the window
+    int target_x;
+    int target_y;
+    int x;
+    int y;
+
+    // Direction to the next tile, and steps to the target, of each tile of the
+    // window by rows. FLOWFIELD_NONE on the target and on the tiles that can't
+    // reach it.
+    int8_t   *next;
+    uint16_t *steps;
+
+    int *queue;
+} flowfield_t;
+
+void flowfield_create(flowfield_t *field, int radius);
+void flowfield_destroy(flowfield_t *field);
+
+// Search again when the target or the map aren't the ones of the last search,
+// true when it did.
+bool flowfield_update(flowfield_t *field, map_t *map, int x, int y);
+
+// Search again on the next update, after a tile of the map changed
+#define flowfield_invalidate(field) ((field)->map = NULL)
+
+// Next tile on the walk from a tile to the target, false when the tile is the
+// target, is out of the window or can't reach the target.
+bool flowfield_next(const flowfield_t *field, int x, int y, int *next_x,
+    int *next_y);
+
+#endif // !FLOWFIELD_H
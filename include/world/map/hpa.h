@@ -0,0 +1,130 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HPA_H
+#define HPA_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include "utils/list.h"
+#include "utils/workers.h"
+#include "world/map/map.h"
+
+// Tiles on each side of the clusters
+#define HPA_CLUSTER_SIZE 16
+
+// The entrances this wide get a portal on each end instead of one on the middle
+#define HPA_WIDE_ENTRANCE 6
+
+// Cost of a step to the sides and on the diagonals, near to 1 and sqrt(2)
+#define HPA_COST_SIDE     2
+#define HPA_COST_DIAGONAL 3
+
+#define HPA_NONE      -1
+#define HPA_UNREACHED INT_MAX
+
+// Tile of a portal on the side of a cluster, its pair is the tile on the other
+// side of the border.
+typedef struct {
+    int x;
+    int y;
+
+    int cluster;
+    int pair;
+
+    // Position on the nodes of the cluster
+    int index;
+} hpa_node_t;
+
+typedef struct {
+    int *nodes;
+    int  count;
+
+    // Cost of the walk inside the cluster from each node to each other, by
+    // rows of count nodes, HPA_UNREACHED when there is no walk.
+    int *costs;
+} hpa_cluster_t;
+
+// Hierarchical pathfinding over the tiles that don't collide on any layer. The
+// map is split on clusters, the walkable runs of tiles on each border between
+// two clusters are its entrances and these have portals, and the clusters keep
+// the costs between their portals. The searches run on the graph of portals
+// and only the leg that is being walked is searched on the tiles.
+typedef struct {
+    map_t *map;
+
+    int columns;
+    int rows;
+    hpa_cluster_t *clusters;
+
+    // Nodes on the side of each cluster of the borders with the cluster on its
+    // right (2 * cluster) and the cluster below it (2 * cluster + 1).
+    list(int) *borders;
+
+    hpa_node_t *nodes;
+    int         nodes_count;
+    int         nodes_capacity;
+
+    // Nodes left by the repairs, used again by the next ones
+    list(int) unused;
+
+    // Changes on each repair, so the paths know they were found before it
+    unsigned generation;
+} hpa_t;
+
+// A path found on the graph and the leg that is being walked, each entity that
+// walks keeps its own. The tiles are indexes by rows of the map.
+typedef struct {
+    int      goal;
+    unsigned generation;
+
+    // Tiles of the portals from the start to the goal, and the next one
+    list(int) waypoints;
+    unsigned  waypoint;
+
+    // Tiles of the walk to the next waypoint
+    list(int) leg;
+} hpa_path_t;
+
+// The workers split the clusters
+void hpa_create(hpa_t *hpa, map_t *map, workers_t *workers);
+void hpa_destroy(hpa_t *hpa);
+
+// Build again the portals around a tile after it's changed by map_set_tile()
+void hpa_repair(hpa_t *hpa, int x, int y);
+
+void hpa_path_create(hpa_path_t *path);
+void hpa_path_destroy(hpa_path_t *path);
+
+// Search the graph for a path from a tile to the goal, false when there is no
+// path. It only reads the graph, so many searches can run at the same time.
+bool hpa_find(const hpa_t *hpa, hpa_path_t *path, int x, int y, int goal_x,
+    int goal_y);
+
+// Next tile on the path from a tile, the leg to the next waypoint is searched
+// when the tile isn't on the last one. False when the tile is the goal, or
+// when the path needs to be found again: the graph was repaired or the tile is
+// away from the next waypoint.
+bool hpa_next(const hpa_t *hpa, hpa_path_t *path, int x, int y, int *next_x,
+    int *next_y);
+
+#define hpa_cluster(hpa, x, y) \
+    (((y) / HPA_CLUSTER_SIZE) * (hpa)->columns + (x) / HPA_CLUSTER_SIZE)
+
+#endif // !HPA_H
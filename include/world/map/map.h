@@ -21,32 +21,93 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define MAP_H
 
 #include <stdbool.h>
+#include <stdio.h>
 #include "world/map/tile.h"
 
 #define MAP_MAX_LAYERS 2
 
+// Steps to the 8 neighbors of a tile. The sides first, so the walks go
+// straight when a diagonal is as short.
+#define MAP_DIRECTIONS 8
+
+extern const int map_direction_x[MAP_DIRECTIONS];
+extern const int map_direction_y[MAP_DIRECTIONS];
+
 enum {
     MAP_LOAD_DIMENSIONS,
     MAP_LOAD_LAYER_0,
     MAP_LOAD_LAYER_1,
 };
 
+// Tile changed on a map that was made by the generator
+typedef struct {
+    int    layer;
+    int    x;
+    int    y;
+    tile_t tile;
+} map_edit_t;
+
+// Called after each tile changed by map_set_tile(), to make again what was
+// built from the tiles around it.
+typedef void (* map_changed_t)(void *context, int x, int y);
+
 typedef struct map {
     tile_t **tiles[MAP_MAX_LAYERS];
 
     int width;
     int height;
+
+    // Seed of the world the map belongs to, it seeds the game random streams
+    // when the map is loaded.
+    unsigned seed;
+
+    // Version of the generator that made the map, 0 when it's unknown. The
+    // maps with a version are saved as the seed and the tiles changed since,
+    // and made again when they're loaded.
+    unsigned generator;
+
+    map_edit_t *edits;
+    unsigned    edits_count;
+    unsigned    edits_capacity;
+
+    map_changed_t changed;
+    void         *changed_context;
 } map_t;
 
+// The map is created empty and with the seed 0, it's set by who made the map
 void map_create(map_t *map, int width, int height);
-bool map_load(map_t *map, int what_load);
 void map_destroy(map_t *map);
 
+// Write the map section of the save format, the map is the same read by
+// map_load() from any save with it. The maps made by the generator are written
+// as their changes, unless these are bigger than the layers.
+void map_write(map_t *map, FILE *file);
+
+// Read the map section that starts on the file position, and leave the file
+// after it. A map written as its changes has no layers, loading its layer 0
+// does nothing and the layer 1 applies the changes to the layers that the
+// generator made again.
+bool map_read(map_t *map, FILE *file, int what_load);
+
+// Load and save the map on the save file of the game (map_file.c), the other
+// functions don't depend on the game so the tools can use them. The maps saved
+// as their changes are made again by the generator when the layer 0 is loaded.
+bool map_load(map_t *map, int what_load);
 bool map_save(map_t *map);
 
 bool map_exists(void);
 
 tile_t map_tile(map_t *map, int layer, int x, int y);
 
+// True when the tile collides on any layer, the tiles out of the map collide
+bool   map_collides(const map_t *map, int x, int y);
+
+// Change a tile, the last change of each tile is kept to be saved. All the
+// changes of the tiles go through it, so the callback of the map sees them.
+void   map_set_tile(map_t *map, int layer, int x, int y, tile_t tile);
+
+// Set the callback of the changes of the tiles, NULL to remove it
+void   map_watch(map_t *map, map_changed_t changed, void *context);
+
 #endif // !MAP_H
 
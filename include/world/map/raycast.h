@@ -0,0 +1,77 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include <stdbool.h>
+#include "utils/workers.h"
+#include "world/map/map.h"
+
+typedef struct {
+    bool hit;
+
+    // Tile that stopped the ray, or the tile of the end of the ray
+    int x;
+    int y;
+
+    // Tiles walked by the ray until it entered the tile hit, or the length of
+    // the ray when nothing was hit.
+    float distance;
+} raycast_hit_t;
+
+// Walk the tiles crossed by a ray, from a point to the direction (dx, dy) and
+// up to the length in tiles, and stop on the first one that collides on any
+// layer. The tiles out of the map collide. It's the DDA of Amanatides and Woo,
+// each step goes to the next tile border that the ray crosses.
+bool raycast(map_t *map, float x, float y, float dx, float dy, float length,
+    raycast_hit_t *hit);
+
+// No tile collides on the segment between the two points
+bool raycast_visible(map_t *map, float x0, float y0, float x1, float y1);
+
+// Structure of arrays with the rays cast together, the hits are written on
+// the same order.
+typedef struct {
+    float *x;
+    float *y;
+
+    float *dx;
+    float *dy;
+    float *length;
+
+    raycast_hit_t *hits;
+
+    unsigned count;
+    unsigned capacity;
+} raycast_batch_t;
+
+void raycast_batch_create(raycast_batch_t *batch);
+void raycast_batch_destroy(raycast_batch_t *batch);
+
+void raycast_batch_add(raycast_batch_t *batch, float x, float y, float dx,
+    float dy, float length);
+
+#define raycast_batch_empty(batch) ((batch)->count = 0)
+
+// Cast all the rays of the batch, the workers split them
+void raycast_batch_cast(raycast_batch_t *batch, map_t *map,
+    workers_t *workers);
+
+#endif // !RAYCAST_H
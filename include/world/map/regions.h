@@ -0,0 +1,61 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef REGIONS_H
+#define REGIONS_H
+
+#include "utils/workers.h"
+#include "world/map/map.h"
+
+#define REGIONS_NONE -1
+
+// Regions of the tiles that can be walked, the ones without collision on any
+// layer, joined by their sides. The regions are numbered in the order of their
+// first tile, by rows, so they don't depend on the workers.
+typedef struct {
+    // Region of each tile by rows, REGIONS_NONE on the tiles that collide
+    int *ids;
+
+    // Tiles of each region
+    unsigned *sizes;
+    unsigned  count;
+
+    int width;
+    int height;
+} regions_t;
+
+// Label the rows [first, last) of the map, the workers split the rows
+void regions_create(regions_t *regions, map_t *map, int first, int last,
+    workers_t *workers);
+void regions_destroy(regions_t *regions);
+
+// Largest region, the first one of them on a tie, or REGIONS_NONE when no tile
+// can be walked.
+int  regions_largest(regions_t *regions);
+
+// Union-find over labels whose parent is never after them, the root of a set
+// is its first label. It joins the regions that were labeled apart.
+int  regions_find(int *parent, int label);
+void regions_union(int *parent, int a, int b);
+
+#define regions_id(regions, x, y) \
+    ((regions)->ids[(y) * (regions)->width + (x)])
+
+#endif // !REGIONS_H
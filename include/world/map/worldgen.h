@@ -0,0 +1,144 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef WORLDGEN_H
+#define WORLDGEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "raylib.h"
+#include "utils/random.h"
+#include "utils/workers.h"
+#include "world/map/map.h"
+#include "world/map/regions.h"
+
+#define WORLDGEN_STAGES 8
+
+// Version of the worlds made from each seed, the maps saved as their seed are
+// made again by the same version. It changes when the worlds change.
+#define WORLDGEN_VERSION 1
+
+// Rows of the bands that the trees and the spawners are placed on, and that
+// the streaming generator makes at time.
+#define WORLDGEN_BAND_ROWS 64
+
+// Generation of a world from its size and seed. It doesn't use the game, only
+// the map and the utils, so it runs on any thread and on the tools. The stages
+// are split in steps, that the game shows one by one.
+typedef struct {
+    map_t map;
+
+    // Rows of the whole world and the first of them that is on the map, the
+    // streaming generator has only a few bands of the world on the map.
+    int height;
+    int origin;
+
+    // Tiles where the player and the spawners are placed, both only on the
+    // largest region so the player can reach all the spawners.
+    Vector2  player;
+    Vector2 *spawners;
+    unsigned spawners_count;
+
+    // Regions of the tiles that can be walked, from the stage 5
+    regions_t regions;
+
+    random_t   random;
+    workers_t *workers;
+
+    // Places left for the trees and the spawners, the stages 4 and 6 sample
+    // them and take some on each step.
+    Vector2 *samples;
+    unsigned samples_count;
+
+    // Samples of the band above the last one placed by the stages 4 and 6
+    struct {
+        Vector2 *samples;
+        unsigned count;
+    } above[2];
+
+    // Seeds of the streams of the bands of the stages 4 and 6
+    uint64_t trees_seed;
+    uint64_t spawners_seed;
+
+    int border_size;
+
+    // Land of the layer 0 on the stage 1, one bit for each tile and the rows
+    // padded to whole words, the passes swap the current and the next.
+    struct {
+        uint64_t *current;
+        uint64_t *next;
+
+        int words;
+    } bitboard;
+
+    int stage;
+    int steps;
+    int band;
+
+    // Steps of the current stage when it started, for the progress
+    int total;
+
+    // Current stage on the hundreds and the percentage of it on the units,
+    // as it was after the last step.
+    int progress;
+
+    // Rows changed by the last step
+    int changed_first;
+    int changed_last;
+
+    // Wall time spent on each stage, in seconds
+    double times[WORLDGEN_STAGES];
+} worldgen_t;
+
+// The workers split the rows of the stages, NULL runs them on the caller. The
+// world only depends on the size and on the seed, not on the workers.
+void worldgen_create(worldgen_t *world, int width, int height, unsigned seed,
+    workers_t *workers);
+void worldgen_destroy(worldgen_t *world);
+
+// Run the next step, false when it was the last of the last stage
+bool worldgen_step(worldgen_t *world);
+void worldgen_run(worldgen_t *world);
+
+const char *worldgen_stage_name(int stage);
+
+// Write a complete save with the map, the player and the spawners, the same
+// that the game loads. The map is written as its seed, unless its generator
+// version is cleared.
+void worldgen_save(worldgen_t *world, FILE *file);
+
+// Make again the layers of a map that was saved as its seed, the map has only
+// the size, the seed and the generator version. False when the version isn't
+// the one of this generator.
+bool worldgen_terrain(map_t *map, workers_t *workers);
+
+// Generate a world straight to a save, a band at time, with only two bands of
+// the world and the rows around one of them in memory, besides the spawners
+// and a label for each region of each band. The bands span the whole width, so
+// the memory is bounded in the height only. The save is the same of
+// worldgen_create(), worldgen_run() and worldgen_save() with all the tiles of
+// the map, the file has to be seekable. The world is left with the times of
+// the stages, the player and the spawners, to be destroyed, and the number of
+// spawners is returned.
+unsigned worldgen_stream(worldgen_t *world, int width, int height,
+    unsigned seed, workers_t *workers, FILE *file);
+
+#endif // !WORLDGEN_H
@@ -18,13 +18,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include "raylib.h"
 #include "game.h"
 #include "scene.h"
 #include "utils/hash.h"
 #include "utils/list.h"
+#include "utils/random.h"
+#include "utils/stats.h"
 #include "utils/utils.h"
+#include "utils/workers.h"
+
+#define GAME_DEFAULT_TICK_RATE 60
+
+// Longest frame time that is simulated, after a hitch the simulation runs
+// slower instead of trying to catch up forever.
+#define GAME_MAX_FRAME_TIME 0.25
 
 static struct {
     struct {
@@ -51,17 +62,45 @@ static struct {
         list(int) previous;
     } touches;
 
+    struct {
+        int   rate;
+        float delta;
+
+        double        accumulator;
+        double        time;
+        unsigned long count;
+
+        // Zero means no limit
+        unsigned long limit;
+    } ticks;
+
     hash(Texture) textures;
 
+    workers_t *workers;
+
+    const char *save_path;
+
+    // Save replaced by the file of game_file_replace(), while it's written
+    char replaced[200];
+
+    unsigned seed;
+    random_t random[RANDOM_STREAMS];
+
     bool running;
+    bool headless;
 } g_game;
 
-bool game_init(int width, int height)
+static void game_draw(void);
+
+bool game_init(int width, int height, bool headless)
 {
     memset(&g_game, 0, sizeof g_game);
 
+    g_game.headless = headless;
+    game_set_seed(time(NULL));
+
     hash_create(g_game.scene.list);
-    g_game.scene.current = (scene_t) { NULL, NULL, NULL, NULL, NULL };
+    g_game.scene.current = (scene_t) { NULL, NULL, NULL, NULL, NULL, NULL };
     g_game.scene.data = NULL;
 
     g_game.running = false;
@@ -71,13 +110,36 @@ bool game_init(int width, int height)
     list_create(g_game.touches.current);
     list_create(g_game.touches.previous);
 
+    g_game.workers = workers_create(workers_cpu_count());
+
+    game_set_tick_rate(GAME_DEFAULT_TICK_RATE);
+
+    g_game.rendering.width = width;
+    g_game.rendering.height = height;
+
+    if (headless) {
+        // Without a window there's nothing to scale, the virtual mouse and
+        // touches are the real ones.
+        g_game.rendering.scale = 1;
+
+        SetTraceLogLevel(LOG_WARNING);
+        ChangeDirectory("assets");
+
+        stats_enable(true);
+
+        return true;
+    }
+
     InitWindow(0, 0, "Game");
+#ifdef PLATFORM_ANDROID
+    // The simulation don't depend on the frame rate, so save battery
+    SetTargetFPS(30);
+#else
     SetTargetFPS(60);
+#endif // PLATFORM_ANDROID
     ToggleFullscreen();
     ChangeDirectory("assets");
 
-    g_game.rendering.width = width;
-    g_game.rendering.height = height;
     g_game.rendering.scale = min((float) GetScreenWidth() / width,
         (float) GetScreenHeight() / height);
 
@@ -103,8 +165,9 @@ bool game_init(int width, int height)
 
 void game_deinit(void)
 {
-    for (unsigned int i = 0; i < hash_size(g_game.textures); i++)
-        UnloadTexture(g_game.textures.values[i]);
+    if (!g_game.headless)
+        for (unsigned int i = 0; i < hash_size(g_game.textures); i++)
+            UnloadTexture(g_game.textures.values[i]);
 
     hash_destroy(g_game.textures);
     hash_destroy(g_game.scene.list);
@@ -112,6 +175,11 @@ void game_deinit(void)
     list_destroy(g_game.touches.current);
     list_destroy(g_game.touches.previous);
 
+    workers_destroy(g_game.workers);
+
+    if (g_game.headless)
+        return;
+
     UnloadRenderTexture(g_game.rendering.target);
     CloseWindow();
 }
@@ -121,7 +189,7 @@ void game_register_scene(scene_t scene)
 
 void game_set_scene(const char *scene_name)
 {
-    scene_t scene = (scene_t) { NULL, NULL, NULL, NULL, NULL };
+    scene_t scene = (scene_t) { NULL, NULL, NULL, NULL, NULL, NULL };
 
     if (g_game.scene.current.name != NULL) {
         if (g_game.scene.current.name == scene_name)
@@ -151,6 +219,9 @@ void game_run(void)
 {
     static int touch_count = -1;
 
+    double start = stats_now();
+    unsigned long ticks = g_game.ticks.count;
+
     if (g_game.scene.current.name != NULL)
         g_game.running = true;
 
@@ -165,27 +236,93 @@ void game_run(void)
                 list_add(g_game.touches.current, GetTouchPointId(i));
         }
 
+        stats_begin("scene update");
         if (g_game.scene.current.name != NULL)
             g_game.scene.current.update(g_game.scene.data);
+        stats_end("scene update");
+
+        // The headless mode runs as fast as it can, one tick for each frame
+        if (g_game.headless)
+            g_game.ticks.accumulator += g_game.ticks.delta;
+        else
+            g_game.ticks.accumulator += min(GetFrameTime(),
+                GAME_MAX_FRAME_TIME);
+
+        // The current scene is fetched on each tick because a tick can change
+        // the scene.
+        while (g_game.ticks.accumulator >= g_game.ticks.delta) {
+            g_game.ticks.accumulator -= g_game.ticks.delta;
+
+            stats_begin("scene tick");
+            if (g_game.running && g_game.scene.current.tick != NULL)
+                g_game.scene.current.tick(g_game.scene.data);
+            stats_end("scene tick");
+
+            g_game.ticks.time += g_game.ticks.delta;
+            g_game.ticks.count++;
+
+            if (g_game.ticks.limit > 0
+                    && g_game.ticks.count >= g_game.ticks.limit)
+                g_game.running = false;
+        }
 
-        BeginTextureMode(g_game.rendering.target);
+        if (!g_game.headless)
+            game_draw();
+    }
 
-        if (g_game.scene.current.name != NULL)
-            g_game.scene.current.draw(g_game.scene.data);
+    g_game.running = false;
 
-        EndTextureMode();
+    if (g_game.headless) {
+        ticks = g_game.ticks.count - ticks;
+        start = stats_now() - start;
 
-        BeginDrawing();
-        ClearBackground(BLACK);
-        DrawTexturePro(g_game.rendering.target.texture,
-            g_game.rendering.target_source, g_game.rendering.target_destination,
-            (Vector2) { 0, 0 }, 0, WHITE);
-        EndDrawing();
+        printf("ticks: %lu in %.3f s (%.1f ticks/s)\n", ticks, start,
+            start > 0 ? ticks / start : 0);
+        stats_print(stdout);
     }
+}
 
-    g_game.running = false;
+void game_set_tick_limit(unsigned long limit)
+{ g_game.ticks.limit = limit; }
+
+void game_set_tick_rate(int rate)
+{
+    g_game.ticks.rate = rate > 0 ? rate : GAME_DEFAULT_TICK_RATE;
+    g_game.ticks.delta = 1.0 / g_game.ticks.rate;
+}
+
+int game_tick_rate(void)
+{ return g_game.ticks.rate; }
+
+float game_tick_delta(void)
+{ return g_game.ticks.delta; }
+
+float game_tick_alpha(void)
+{ return g_game.ticks.accumulator / g_game.ticks.delta; }
+
+unsigned long game_ticks(void)
+{ return g_game.ticks.count; }
+
+double game_time(void)
+{ return g_game.ticks.time; }
+
+void game_set_seed(unsigned seed)
+{
+    g_game.seed = seed;
+
+    for (int stream = 0; stream < RANDOM_STREAMS; stream++)
+        random_seed(&g_game.random[stream], seed, stream);
 }
 
+unsigned game_seed(void)
+{ return g_game.seed; }
+
+random_t *game_random(random_stream_t stream)
+{ return &g_game.random[stream]; }
+
+bool game_headless(void)
+{ return g_game.headless; }
+
 int game_width(void)
 { return g_game.rendering.width; }
 
@@ -197,6 +334,9 @@ FILE *game_file(const char *mode)
     char filename[200] = "../game.sav";
     FILE *file;
 
+    if (g_game.save_path != NULL)
+        return fopen(g_game.save_path, mode);
+
     if ((file = fopen(filename, mode)) == NULL) {
         sprintf(filename, "/storage/emulated/0/game.sav");
         file = fopen(filename, mode);
@@ -205,6 +345,69 @@ FILE *game_file(const char *mode)
     return file;
 }
 
+FILE *game_file_replace(void)
+{
+    char filename[sizeof(g_game.replaced) + 4];
+    FILE *file;
+
+    const char *paths[] = { "../game.sav", "/storage/emulated/0/game.sav" };
+
+    if (g_game.save_path != NULL) {
+        snprintf(g_game.replaced, sizeof(g_game.replaced), "%s",
+            g_game.save_path);
+        snprintf(filename, sizeof(filename), "%s.tmp", g_game.replaced);
+
+        return fopen(filename, "w");
+    }
+
+    for (unsigned i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        snprintf(g_game.replaced, sizeof(g_game.replaced), "%s", paths[i]);
+        snprintf(filename, sizeof(filename), "%s.tmp", g_game.replaced);
+
+        if ((file = fopen(filename, "w")) != NULL)
+            return file;
+    }
+
+    return NULL;
+}
+
+bool game_file_commit(FILE *file)
+{
+    char filename[sizeof(g_game.replaced) + 4];
+    bool written;
+
+    snprintf(filename, sizeof(filename), "%s.tmp", g_game.replaced);
+
+    written = !ferror(file);
+    written = fclose(file) == 0 && written;
+
+    if (!written) {
+        remove(filename);
+        return false;
+    }
+
+    // Some systems don't rename over a file that exists, there the old save is
+    // only removed once the new one is complete.
+    if (rename(filename, g_game.replaced) != 0
+            && (remove(g_game.replaced) != 0
+                || rename(filename, g_game.replaced) != 0))
+        return false;
+
+    return true;
+}
+
+void game_set_save_path(const char *path)
+{ g_game.save_path = path; }
+
+void game_set_threads(unsigned threads)
+{
+    workers_destroy(g_game.workers);
+    g_game.workers = workers_create(threads);
+}
+
+workers_t *game_workers(void)
+{ return g_game.workers; }
+
 Vector2 game_virtual_mouse(void)
 {
     Vector2 mouse = GetMousePosition();
@@ -274,7 +477,28 @@ bool game_touch_released(int touch_id)
 
 Texture game_load_texture(const char *filename, const char *name)
 {
-    Texture texture = LoadTexture(filename);
+    Texture texture;
+    Image image;
+
+    // There's no GPU to upload to, but the entities still need the texture
+    // dimensions to know the number of frames of the animations.
+    if (g_game.headless) {
+        image = LoadImage(filename);
+
+        texture = (Texture) {
+            .id = 0,
+
+            .width = image.width,
+            .height = image.height,
+            .mipmaps = image.mipmaps,
+            .format = image.format,
+        };
+
+        UnloadImage(image);
+    } else {
+        texture = LoadTexture(filename);
+    }
+
     hash_add(g_game.textures, name, texture);
 
     return texture;
@@ -288,3 +512,24 @@ Texture game_get_texture(const char *name)
     return texture;
 }
 
+
+static void game_draw(void)
+{
+    stats_begin("scene draw");
+
+    BeginTextureMode(g_game.rendering.target);
+
+    if (g_game.scene.current.name != NULL)
+        g_game.scene.current.draw(g_game.scene.data);
+
+    EndTextureMode();
+
+    BeginDrawing();
+    ClearBackground(BLACK);
+    DrawTexturePro(g_game.rendering.target.texture,
+        g_game.rendering.target_source, g_game.rendering.target_destination,
+        (Vector2) { 0, 0 }, 0, WHITE);
+    EndDrawing();
+
+    stats_end("scene draw");
+}
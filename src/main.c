@@ -17,18 +17,86 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "game.h"
+#include "record.h"
 #include "scene.h"
+#include "utils/fastmath.h"
+#include "world/entity/movement.h"
 
 int main (int argc, char *argv[])
 {
-    (void) argc; (void) argv;
+    bool headless = false;
+
+    const char *record = NULL;
+    const char *replay = NULL;
+
+    for (int i = 1; i < argc; i++)
+        if (strcmp(argv[i], "--headless") == 0)
+            headless = true;
+
+    // Only compare the fast math against libm, or the movement paths, without
+    // the game
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--benchmark-math") == 0) {
+            fastmath_benchmark(stdout);
+            return EXIT_SUCCESS;
+        }
+
+        // Fails when the vector lanes don't resolve as the scalar path
+        if (strcmp(argv[i], "--check-movement") == 0)
+            return movement_check(stdout) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
-    if (!game_init(1280, 720))
+    if (!game_init(1280, 720, headless))
         return EXIT_FAILURE;
 
-    { // Scenes
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            game_set_threads(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+            game_set_tick_rate(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+            game_set_tick_limit(strtoul(argv[++i], NULL, 10));
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            game_set_save_path(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            game_set_seed(strtoul(argv[++i], NULL, 10));
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            record = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replay = argv[++i];
+    }
+
+    // The recording starts on the world generation so a replay of it only
+    // depends on the seed and the save file it started with.
+    if (replay != NULL || record != NULL) {
+        if (!record_open(replay != NULL ? replay : record,
+                    replay != NULL ? RECORD_REPLAY : RECORD_WRITE,
+                    game_seed(), game_tick_rate())) {
+            fprintf(stderr, "Couldn't open the recording %s\n",
+                replay != NULL ? replay : record);
+
+            game_deinit();
+            return EXIT_FAILURE;
+        }
+
+        game_set_seed(record_seed());
+        game_set_tick_rate(record_tick_rate());
+    }
+
+    // Only the world generation and the gameplay simulation, when the game
+    // leaves them the run ends.
+    if (headless) {
+        SCENE_IMPORT(genmap);
+        game_register_scene(SCENE_TICKED(genmap));
+
+        SCENE_IMPORT(gameplay);
+        game_register_scene(SCENE_TICKED(gameplay));
+    } else { // Scenes
         SCENE_IMPORT(logo);
         game_register_scene(SCENE(logo));
 
@@ -39,10 +107,10 @@ int main (int argc, char *argv[])
         game_register_scene(SCENE(menu));
 
         SCENE_IMPORT(genmap);
-        game_register_scene(SCENE(genmap));
+        game_register_scene(SCENE_TICKED(genmap));
 
         SCENE_IMPORT(gameplay);
-        game_register_scene(SCENE(gameplay));
+        game_register_scene(SCENE_TICKED(gameplay));
 
         SCENE_IMPORT(gameover);
         game_register_scene(SCENE(gameover));
@@ -88,10 +156,17 @@ int main (int argc, char *argv[])
         game_load_texture("sword.png", "player-sword");
     }
 
-    game_set_scene("logo");
+    game_set_scene(headless || record_mode() != RECORD_OFF ? "genmap" : "logo");
     game_run();
 
     game_deinit();
+
+    if (record_diverged()) {
+        record_close();
+        return EXIT_FAILURE;
+    }
+
+    record_close();
     return EXIT_SUCCESS;
 }
 
@@ -0,0 +1,195 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "record.h"
+
+// Changes with the format and with the simulation, the recordings of other
+// versions don't replay the same.
+#define RECORD_VERSION 12
+
+// Each tick is a flags byte, the payloads of the set flags and the checksum
+// of the world after the tick, an idle tick takes 5 bytes.
+enum {
+    RECORD_DIRECTION       = 1 << 0,
+    RECORD_ATTACK_PRESSED  = 1 << 1,
+    RECORD_ATTACK_RELEASED = 1 << 2,
+    RECORD_MOUSE_PRESSED   = 1 << 3,
+};
+
+static struct {
+    FILE *file;
+
+    record_mode_t mode;
+    unsigned      seed;
+    int           tick_rate;
+
+    // The direction is only stored when it changes
+    Vector2 direction;
+
+    unsigned long ticks;
+    bool          diverged;
+} g_record;
+
+bool record_open(const char *filename, record_mode_t mode, unsigned seed,
+    int tick_rate)
+{
+    char token[21];
+    int version;
+
+    record_close();
+
+    if (mode == RECORD_OFF)
+        return true;
+
+    if ((g_record.file = fopen(filename, mode == RECORD_WRITE ? "wb" : "rb"))
+            == NULL)
+        return false;
+
+    if (mode == RECORD_WRITE) {
+        fprintf(g_record.file, "<Record %d %u %d\n", RECORD_VERSION, seed,
+            tick_rate);
+    } else if (fscanf(g_record.file, "<%20s %d %u %d", token, &version, &seed,
+                &tick_rate) != 4 || strcmp(token, "Record") != 0
+            || version != RECORD_VERSION) {
+        fclose(g_record.file);
+        g_record.file = NULL;
+
+        return false;
+    } else {
+        // Discard the newline character preceded by the header
+        fgetc(g_record.file);
+    }
+
+    g_record.mode = mode;
+    g_record.seed = seed;
+    g_record.tick_rate = tick_rate;
+
+    return true;
+}
+
+void record_close(void)
+{
+    if (g_record.file != NULL)
+        fclose(g_record.file);
+
+    memset(&g_record, 0, sizeof g_record);
+}
+
+record_mode_t record_mode(void)
+{ return g_record.mode; }
+
+unsigned record_seed(void)
+{ return g_record.seed; }
+
+int record_tick_rate(void)
+{ return g_record.tick_rate; }
+
+bool record_input(record_input_t *input)
+{
+    uint8_t flags = 0;
+    int c;
+
+    switch (g_record.mode) {
+    case RECORD_OFF:
+        return true;
+
+    case RECORD_WRITE:
+        if (input->direction.x != g_record.direction.x
+                || input->direction.y != g_record.direction.y)
+            flags |= RECORD_DIRECTION;
+
+        flags |= input->attack_pressed ? RECORD_ATTACK_PRESSED : 0;
+        flags |= input->attack_released ? RECORD_ATTACK_RELEASED : 0;
+        flags |= input->mouse_pressed ? RECORD_MOUSE_PRESSED : 0;
+
+        fputc(flags, g_record.file);
+
+        if (flags & RECORD_DIRECTION)
+            fwrite(&input->direction, sizeof(Vector2), 1, g_record.file);
+
+        if (flags & RECORD_MOUSE_PRESSED)
+            fwrite(&input->mouse, sizeof(Vector2), 1, g_record.file);
+
+        break;
+
+    case RECORD_REPLAY:
+        if ((c = fgetc(g_record.file)) == EOF)
+            return false;
+
+        flags = c;
+
+        if ((flags & RECORD_DIRECTION)
+                && fread(&g_record.direction, sizeof(Vector2), 1,
+                    g_record.file) != 1)
+            return false;
+
+        input->direction = g_record.direction;
+        input->attack_pressed = flags & RECORD_ATTACK_PRESSED;
+        input->attack_released = flags & RECORD_ATTACK_RELEASED;
+        input->mouse_pressed = flags & RECORD_MOUSE_PRESSED;
+
+        if (input->mouse_pressed
+                && fread(&input->mouse, sizeof(Vector2), 1, g_record.file) != 1)
+            return false;
+
+        break;
+    }
+
+    g_record.direction = input->direction;
+
+    return true;
+}
+
+bool record_checksum(uint32_t checksum)
+{
+    uint32_t recorded;
+
+    switch (g_record.mode) {
+    case RECORD_OFF:
+        break;
+
+    case RECORD_WRITE:
+        fwrite(&checksum, sizeof(uint32_t), 1, g_record.file);
+        break;
+
+    case RECORD_REPLAY:
+        if (fread(&recorded, sizeof(uint32_t), 1, g_record.file) != 1)
+            break;
+
+        if (recorded != checksum && !g_record.diverged) {
+            fprintf(stderr, "Replay diverged on tick %lu: expected %08x, "
+                "got %08x\n", g_record.ticks, (unsigned) recorded,
+                (unsigned) checksum);
+
+            g_record.diverged = true;
+        }
+        break;
+    }
+
+    g_record.ticks++;
+
+    return !g_record.diverged;
+}
+
+bool record_diverged(void)
+{ return g_record.diverged; }
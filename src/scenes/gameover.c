@@ -19,6 +19,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include "raylib.h"
 #include "game.h"
 #include "scene.h"
@@ -58,8 +59,9 @@ scene_data_t *gameover_init(void)
 
 void gameover_deinit(scene_data_t *data)
 {
-    // Erase the game save
+    // Erase the game save, the next one is a new world
     fclose(game_file("w"));
+    game_set_seed(time(NULL));
 
     UnloadFont(data->alagard);
     free(data);
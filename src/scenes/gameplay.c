@@ -20,9 +20,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <math.h>
 #include <stdlib.h>
 #include "game.h"
+#include "record.h"
 #include "scene.h"
 #include "utils/utils.h"
+#include "utils/fastmath.h"
 #include "utils/list.h"
+#include "utils/stats.h"
+#include "world/map/clearance.h"
+#include "world/map/hpa.h"
 #include "world/map/map.h"
 #include "world/map/tile.h"
 #include "world/entity/spawner.h"
@@ -32,11 +37,19 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "ui/virtual_joystick.h"
 #endif // PLATFORM_ANDROID
 
-#define GAMEPLAY_LOAD_STAGES 5
+#define GAMEPLAY_LOAD_STAGES 6
+
+// Tiles around the player that are searched for one that doesn't collide,
+// when it's loaded on one that does.
+#define GAMEPLAY_PLAYER_RADIUS 16
 
 struct scene_data {
     map_t map;
 
+    // Built once the map is loaded, repaired by who changes its tiles
+    hpa_t       hpa;
+    clearance_t clearance;
+
     // The first entity its always the player.
     entity_list_t entities;
 
@@ -49,6 +62,11 @@ struct scene_data {
     Rectangle attack_button;
 #endif // PLATFORM_ANDROID
 
+    // Input sampled on each frame and consumed by the next tick
+    record_input_t input;
+
+    // The camera of the previous tick, used to interpolate the drawing
+    Rectangle previous_camera;
     Rectangle camera;
     Texture spritesheet;
 
@@ -68,6 +86,10 @@ struct scene_data {
 };
 
 static void update_loading(scene_data_t *data);
+static void place_player(scene_data_t *data);
+static void follow_player(scene_data_t *data);
+static void map_changed(void *data, int x, int y);
+static void update_input(scene_data_t *data);
 static void update_game(scene_data_t *data);
 
 static void draw_loading(scene_data_t *data);
@@ -90,6 +112,11 @@ scene_data_t *gameplay_init(void)
         .width = ceil((float) game_width() / TILE_DRAW_SIZE) + 1,
         .height = ceil((float) game_height() / TILE_DRAW_SIZE) + 1,
     };
+    data->input.direction = (Vector2) { 0, 0 };
+    data->input.attack_pressed = false;
+    data->input.attack_released = false;
+    data->input.mouse_pressed = false;
+    data->input.mouse = (Vector2) { 0, 0 };
 
     data->spritesheet = game_get_texture("tiles");
 
@@ -146,6 +173,8 @@ void gameplay_deinit(scene_data_t *data)
     player_save((player_t *) list_get(data->entities, 0));
     spawner_save(&data->spawners);
 
+    hpa_destroy(&data->hpa);
+    clearance_destroy(&data->clearance);
     map_destroy(&data->map);
     entity_destroy(&data->entities);
     spawner_destroy(&data->spawners);
@@ -155,6 +184,12 @@ void gameplay_deinit(scene_data_t *data)
 
 
 void gameplay_update(scene_data_t *data)
+{
+    if (data->loading_stage >= GAMEPLAY_LOAD_STAGES)
+        update_input(data);
+}
+
+void gameplay_tick(scene_data_t *data)
 {
     if (data->loading_stage < GAMEPLAY_LOAD_STAGES)
         update_loading(data);
@@ -172,108 +207,199 @@ void gameplay_draw(scene_data_t *data)
 
 static void update_loading(scene_data_t *data)
 {
+    stats_begin("gameplay loading");
+
     switch (data->loading_stage) {
     // Load map dimensions
     case 0:
         map_load(&data->map, MAP_LOAD_DIMENSIONS);
+
+        // The simulation streams restart from the world seed
+        game_set_seed(data->map.seed);
         break;
 
-    // Load map layer 0
+    // Load map layer 0, or make both layers again from the seed
     case 1:
         map_load(&data->map, MAP_LOAD_LAYER_0);
         break;
 
-    // Load map layer 1
+    // Load map layer 1, or the tiles changed since the map was made
     case 2:
         map_load(&data->map, MAP_LOAD_LAYER_1);
         break;
 
-    // Load player state
+    // Build the paths between the clusters of the map and the distances to
+    // its obstacles.
     case 3:
+        hpa_create(&data->hpa, &data->map, game_workers());
+        clearance_create(&data->clearance, &data->map);
+
+        // From now on the changes of the tiles repair them
+        map_watch(&data->map, map_changed, data);
+        break;
+
+    // Load player state
+    case 4:
         list_add(data->entities, (entity_t *) player_create((Vector2) { 0, 0 }));
         player_load((player_t *) list_get(data->entities, 0));
+        place_player(data);
+
+        // The first frame is drawn already on the player, instead of coming
+        // from the corner of the map.
+        follow_player(data);
+        data->previous_camera = data->camera;
         break;
 
     // Load spawners
-    case 4:
+    case 5:
         spawner_create(&data->spawners);
         spawner_load(&data->spawners);
         break;
     }
 
     data->loading_stage++;
+
+    stats_end("gameplay loading");
 }
 
-static void update_game(scene_data_t *data)
+// Move the player to the nearest tile that doesn't collide when the one it was
+// saved on does, as when the tile was changed after.
+static void place_player(scene_data_t *data)
+{
+    const float half = ENTITY_TILE_SIZE / TILE_DRAW_SIZE / 2;
+
+    entity_t *player = list_get(data->entities, 0);
+    int x, y;
+
+    if (clearance_at(&data->clearance, player->position.x + half,
+                player->position.y + half) >= 1)
+        return;
+
+    if (clearance_nearest(&data->clearance, player->position.x + half,
+                player->position.y + half, 1, GAMEPLAY_PLAYER_RADIUS, &x, &y)) {
+        player->position.x = x + 0.5 - half;
+        player->position.y = y + 0.5 - half;
+        player->previous_position = player->position;
+    }
+}
+
+// Repair what was built from the tiles around the changed one, the flow field
+// is searched again on the next tick.
+static void map_changed(void *data, int x, int y)
+{
+    hpa_repair(&((scene_data_t *) data)->hpa, x, y);
+    clearance_update(&((scene_data_t *) data)->clearance, x, y);
+    entity_map_changed();
+}
+
+// Center the camera on the player, without leaving the map
+static void follow_player(scene_data_t *data)
+{
+    entity_t *player = list_get(data->entities, 0);
+
+    // NOTE: The +1 its to really centralize the camera.
+    data->camera.x = player->position.x + 1 - data->camera.width / 2;
+    data->camera.y = player->position.y + 1 - data->camera.height / 2;
+
+    if (data->camera.x < 0)
+        data->camera.x = 0;
+    else if (data->camera.x >= data->map.width - data->camera.width)
+        data->camera.x = data->map.width - data->camera.width;
+
+    if (data->camera.y < 0)
+        data->camera.y = 0;
+    else if (data->camera.y >= data->map.height - data->camera.height)
+        data->camera.y = data->map.height - data->camera.height;
+}
+
+static void update_input(scene_data_t *data)
 {
     Vector2 direction = { 0, 0 };
-    player_t *player = (player_t *) list_get(data->entities, 0);
 
-    if (!data->paused && data->saving == 0) {
 #ifdef PLATFORM_ANDROID
-        direction = virtual_joystick_update(&data->virtual_joystick);
-
-        for (int i = 0; i < min(GetTouchPointCount(), 2); i++)
-            if (CheckCollisionPointRec(game_virtual_touch(i),
-                        data->attack_button)
-                    && game_touch_pressed(game_touch_id(i))
-                    && !player->attacked)
-                player->attacking = GetTime();
-
-        for (int i = 0; i < 2; i++)
-            if (CheckCollisionPointRec(game_virtual_touch(i),
-                        data->attack_button)
-                    && game_touch_released(game_touch_id(i)))
-                player->attacked = false;
+    direction = virtual_joystick_update(&data->virtual_joystick);
+
+    for (int i = 0; i < min(GetTouchPointCount(), 2); i++)
+        if (CheckCollisionPointRec(game_virtual_touch(i), data->attack_button)
+                && game_touch_pressed(game_touch_id(i)))
+            data->input.attack_pressed = true;
+
+    for (int i = 0; i < 2; i++)
+        if (CheckCollisionPointRec(game_virtual_touch(i), data->attack_button)
+                && game_touch_released(game_touch_id(i)))
+            data->input.attack_released = true;
 #else
-        if (IsKeyDown(KEY_W))
-            direction.y = -1;
-        else if (IsKeyDown(KEY_S))
-            direction.y = 1;
-
-        if (IsKeyDown(KEY_D))
-            direction.x = 1;
-        else if (IsKeyDown(KEY_A))
-            direction.x = -1;
-
-        if (IsKeyPressed(KEY_E) && !player->attacked)
-            player->attacking = GetTime();
-        else if (IsKeyReleased(KEY_E))
-            player->attacked = false;
+    if (IsKeyDown(KEY_W))
+        direction.y = -1;
+    else if (IsKeyDown(KEY_S))
+        direction.y = 1;
+
+    if (IsKeyDown(KEY_D))
+        direction.x = 1;
+    else if (IsKeyDown(KEY_A))
+        direction.x = -1;
+
+    if (IsKeyPressed(KEY_E))
+        data->input.attack_pressed = true;
+    else if (IsKeyReleased(KEY_E))
+        data->input.attack_released = true;
 #endif // PLATFORM_ANDROID
 
+    data->input.direction = direction;
+
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        data->input.mouse_pressed = true;
+        data->input.mouse = game_virtual_mouse();
+    }
+}
+
+static void update_game(scene_data_t *data)
+{
+    record_input_t input = data->input;
+    player_t *player = (player_t *) list_get(data->entities, 0);
+
+    // The presses and releases are consumed by a single tick, the direction
+    // is kept until the next sample.
+    data->input.attack_pressed = false;
+    data->input.attack_released = false;
+    data->input.mouse_pressed = false;
+
+    if (!record_input(&input)) {
+        game_end_run();
+        return;
+    }
+
+    data->previous_camera = data->camera;
+
+    if (!data->paused && data->saving == 0) {
+        if (input.attack_pressed && !player->attacked)
+            player_attack(player);
+        else if (input.attack_released)
+            player->attacked = false;
+
         // Update the player state
-        if ((direction.x != 0 || direction.y != 0)
+        if ((input.direction.x != 0 || input.direction.y != 0)
                 && player->base.state != ENTITY_STATE_DAMAGING) {
-            player->base.direction = vec2ang(direction.x, direction.y);
+            player->base.direction = fastmath_angle(input.direction.x,
+                input.direction.y);
             player->base.state = ENTITY_STATE_MOVING;
         } else if (player->base.state != ENTITY_STATE_DAMAGING) {
             player->base.state = ENTITY_STATE_IDLE;
         }
 
-        // Update the game camera
-        // NOTE: The +1 its to really centralize the camera.
-        data->camera.x = player->base.position.x + 1
-            - data->camera.width / 2;
-
-        data->camera.y = player->base.position.y + 1
-            - data->camera.height / 2;
+        follow_player(data);
 
-        if (data->camera.x < 0)
-            data->camera.x = 0;
-        else if (data->camera.x >= data->map.width - data->camera.width)
-            data->camera.x = data->map.width - data->camera.width;
+        stats_begin("entities");
+        entity_update(&data->entities, &data->map, &data->hpa,
+            &data->clearance, data->camera, game_workers());
+        stats_end("entities");
 
-        if (data->camera.y < 0)
-            data->camera.y = 0;
-        else if (data->camera.y >= data->map.height - data->camera.height)
-            data->camera.y = data->map.height - data->camera.height;
+        stats_begin("spawners");
+        spawner_update(&data->spawners, &data->entities, &data->clearance);
+        stats_end("spawners");
 
-        entity_update(&data->entities, &data->map, data->camera);
-        spawner_update(&data->spawners, &data->entities);
-
-        if (CheckCollisionPointRec(game_virtual_mouse(), data->save_button)
-                && IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+        if (input.mouse_pressed
+                && CheckCollisionPointRec(input.mouse, data->save_button))
             data->saving = 3;
     }
 
@@ -292,14 +418,18 @@ static void update_game(scene_data_t *data)
     }
     data->saving -= data->saving > 0;
 
-    if (data->saving == 0) {
-        if (CheckCollisionPointRec(game_virtual_mouse(), data->pause_button)
-                && IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+    if (!record_checksum(entity_checksum(&data->entities)))
+        game_end_run();
+
+    if (data->saving == 0 && input.mouse_pressed) {
+        if (CheckCollisionPointRec(input.mouse, data->pause_button))
             data->paused = !data->paused;
 
-        if (CheckCollisionPointRec(game_virtual_mouse(), data->back_button)
-                && IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+        // The scene data is freed by the scene change
+        if (CheckCollisionPointRec(input.mouse, data->back_button)) {
             game_set_scene("menu");
+            return;
+        }
     }
 
     if (player->base.hearts <= 0)
@@ -321,19 +451,32 @@ static void draw_loading(scene_data_t *data)
     case 2:
         break;
 
-    // Draw loading player state
+    // Draw building the paths and the distances
     case 3:
         break;
 
-    // Draw loading spawners
+    // Draw loading player state
     case 4:
         break;
+
+    // Draw loading spawners
+    case 5:
+        break;
     }
 }
 
 static void draw_game(scene_data_t *data)
 {
     int camera_x, camera_y;
+    float alpha = game_tick_alpha();
+
+    Rectangle camera = {
+        .x = lerp(data->previous_camera.x, data->camera.x, alpha),
+        .y = lerp(data->previous_camera.y, data->camera.y, alpha),
+
+        .width = data->camera.width,
+        .height = data->camera.height,
+    };
 
     Rectangle tile = {
         .width = TILE_DRAW_SIZE,
@@ -348,17 +491,17 @@ static void draw_game(scene_data_t *data)
     ClearBackground(BLACK);
 
     for (int layer = 0; layer < MAP_MAX_LAYERS; layer++) {
-        for (int y = 0; y < data->camera.height; y++) {
-            camera_y = y + data->camera.y;
+        for (int y = 0; y < camera.height; y++) {
+            camera_y = y + camera.y;
 
-            for (int x = 0; x < data->camera.width; x++) {
-                camera_x = x + data->camera.x;
+            for (int x = 0; x < camera.width; x++) {
+                camera_x = x + camera.x;
 
                 if (tile_empty(data->map.tiles[layer][camera_y][camera_x]))
                     continue;
 
-                tile.x = (camera_x - data->camera.x) * tile.width;
-                tile.y = (camera_y - data->camera.y) * tile.height;
+                tile.x = (camera_x - camera.x) * tile.width;
+                tile.y = (camera_y - camera.y) * tile.height;
 
                 sprite.x = tile_x(data->map.tiles[layer][camera_y][camera_x])
                     * fabs(sprite.width);
@@ -390,7 +533,7 @@ static void draw_game(scene_data_t *data)
         }
     }
 
-    entity_draw(&data->entities, data->camera);
+    entity_draw(&data->entities, camera, alpha);
 
     if (data->paused) {
         DrawTexturePro(data->unpause,
@@ -17,648 +17,475 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
-#include <time.h>
 #include "raylib.h"
 #include "game.h"
 #include "scene.h"
-#include "utils/list.h"
+#include "utils/stats.h"
+#include "utils/utils.h"
+#include "utils/workers.h"
 #include "world/map/map.h"
 #include "world/map/tile.h"
-#include "world/entity/spawner.h"
-#include "world/entity/player.h"
+#include "world/map/worldgen.h"
 
 #define GENMAP_MAP_BASE_SIZE          300
-#define GENMAP_MAP_LAND_SPAWN_RATE    (55.0 / 100.0)
-#define GENMAP_TREE_GENERATION_FACTOR (5.0 / 100.0)
 
-#define GENMAP_FLOWER_SPAWN_RATE      (8.0 / 100.0)
-#define GENMAP_SINGLE_ROCK_SPAWN_RATE (0.5 / 100.0)
-#define GENMAP_ROCKS_SPAWN_RATE       (40.0 / 100.0)
-#define GENMAP_GRAVESTONE_SPAWN_RATE  (20.0 / 100.0)
+// Sprites of the tiles spritesheet, the preview uses the mean color of each
+#define GENMAP_SPRITE_SIZE            16
+#define GENMAP_PALETTE_COLUMNS        16
+#define GENMAP_PALETTE_ROWS           8
 
-#define GENMAP_STEP_CHANGE_DELAY      (100.0 / 1000.0)
-
-#define MIN(a, b) ((a) < (b) ? (a) : (b))
-
-enum {
-    GENMAP_STEPS_STAGE0 = 1,
-    GENMAP_STEPS_STAGE1 = 10,
-    GENMAP_STEPS_STAGE2 = 5,
-    GENMAP_STEPS_STAGE4 = 5,
-    GENMAP_STEPS_STAGE6 = 1,
+struct scene_data {
+    worldgen_t world;
+
+    // The world is only generated when there's no map saved
+    bool new_world;
+
+    // Running on its own thread, with its own workers as the ones of the game
+    // are destroyed before the exit waits for it. The stages are only measured
+    // when running on the main thread.
+    bool       background;
+    workers_t *workers;
+
+    // Preview of the map with one pixel for each tile, the generation writes
+    // the rows that changed and the scene uploads only them to the texture.
+    // It isn't made while headless.
+    struct {
+        Color *pixels;
+        int    width;
+        int    height;
+
+        int first_row;
+        int last_row;
+
+        Vector2 *spawners;
+        unsigned spawners_count;
+
+        pthread_mutex_t lock;
+        Texture         texture;
+    } preview;
 };
 
-struct scene_data {
-    map_t map;
-    player_t *player;
+static struct {
+    // Mean color of each sprite of the tiles, by its row and column
+    Color palette[GENMAP_PALETTE_ROWS][GENMAP_PALETTE_COLUMNS];
+    bool  palette_ready;
 
-    list(Vector2) spawn_points;
-    spawner_list_t spawners;
+    // World being generated, from genmap_start() until the scene is left
+    scene_data_t *data;
+    pthread_t     thread;
 
-    int map_border_size;
+    bool started;
+    bool threaded;
+    bool exit_registered;
 
-    int    generation_steps;
-    int    generation_stage;
-    double generation_stage_time;
+    // Current stage on the hundreds and the percentage of it on the units,
+    // it's WORLDGEN_STAGES * 100 when the world is saved.
+    atomic_int progress;
 
-    Texture spritesheet;
-};
+    // The world couldn't be saved, the old save is left as it was
+    atomic_bool failed;
+} g_genmap;
 
-static void genmap_stage0(scene_data_t *data);
-static void genmap_stage1(scene_data_t *data);
-static void genmap_stage2(scene_data_t *data);
-static void genmap_stage3(scene_data_t *data);
-static void genmap_stage4(scene_data_t *data);
-static void genmap_stage5(scene_data_t *data);
-static void genmap_stage6(scene_data_t *data);
+static scene_data_t *genmap_create(void);
+static void genmap_destroy(scene_data_t *data);
+static void *genmap_generate(void *data);
+static bool genmap_save(scene_data_t *data);
+static void genmap_wait(void);
 
-// Helper functions
-static int stage1_count_neighbors(map_t *map, int x, int y);
-static int stage2_find_neighbors(map_t *map, int x, int y);
-static int stage4_count_neighbors(map_t *map, int x, int y, tile_t tile);
-static void stage5_generate_spawners(scene_data_t *data, int spawners);
+static void genmap_publish(scene_data_t *data);
+static void genmap_load_palette(void);
+static Color genmap_tile_color(tile_t ground, tile_t decoration);
 
 scene_data_t *genmap_init(void)
 {
-    const int width = game_width();
-    const int height = game_height();
-
-    int map_width, map_height;
-
-    srand(time(NULL));
-    scene_data_t *data = malloc(sizeof(scene_data_t));
-
-    if (!map_exists()) {
-        if (width < height) {
-            map_width = GENMAP_MAP_BASE_SIZE;
-            map_height = ((float) height / width) * map_width;
-        } else {
-            map_height = GENMAP_MAP_BASE_SIZE;
-            map_width = ((float) width / height) * map_height;
-        }
-
-        map_create(&data->map, map_width, map_height);
-
-        if (!spawner_exists()) {
-            list_create(data->spawn_points);
-            spawner_create(&data->spawners);
-        }
-    } else {
-        // Jump to the last stage that change to game scene
-        data->generation_stage = 7;
-        data->generation_stage_time = 0;
-
-        return data;
-    }
-
-    data->map_border_size = 5;
-
-    data->generation_steps = 0;
-    data->generation_stage = 0;
-    data->generation_stage_time = 0;
-
-    data->spritesheet = game_get_texture("tiles");
+    // Usually it was started when the menu was left
+    genmap_start();
 
-    return data;
+    return g_genmap.data;
 }
 
 void genmap_deinit(scene_data_t *data)
 {
-    if (!map_exists()) {
-        map_save(&data->map);
-        map_destroy(&data->map);
-    }
-
-    if (!player_exists())
-        player_save(data->player);
-
-    if (!spawner_exists()) {
-        list_destroy(data->spawn_points);
+    // The textures can only be unloaded here, not at the exit
+    if (data->preview.texture.id != 0)
+        UnloadTexture(data->preview.texture);
 
-        spawner_save(&data->spawners);
-        spawner_destroy(&data->spawners);
-    }
-
-    free(data);
+    genmap_wait();
 }
 
 void genmap_update(scene_data_t *data)
 {
-    if (GetTime() - data->generation_stage_time <= GENMAP_STEP_CHANGE_DELAY)
-        return;
+    (void) data;
+}
 
-    switch (data->generation_stage) {
-    case 0:
-        genmap_stage0(data);
-        break;
-    case 1:
-        genmap_stage1(data);
-        break;
-    case 2:
-        genmap_stage2(data);
-        break;
-    case 3:
-        genmap_stage3(data);
-        break;
-    case 4:
-        genmap_stage4(data);
-        break;
-    case 5:
-        genmap_stage5(data);
-        break;
-    case 6:
-        genmap_stage6(data);
-        break;
-    default:
-        game_set_scene("gameplay");
+void genmap_tick(scene_data_t *data)
+{
+    // There's nothing to overlap with the generation while headless, it runs
+    // here so it's measured and the ticks after it are always the same.
+    if (!g_genmap.threaded)
+        genmap_generate(data);
+
+    if (atomic_load(&g_genmap.failed)) {
+        fprintf(stderr, "Couldn't save the new world\n");
+
+        game_end_run();
         return;
     }
 
-    if (--data->generation_steps == 0)
-        data->generation_stage++;
-
-    data->generation_stage_time = GetTime();
+    if (genmap_progress() >= 1)
+        game_set_scene("gameplay");
 }
 
 void genmap_draw(scene_data_t *data)
 {
-    int draw_layers = 0;
+    const float progress = genmap_progress();
 
-    Rectangle tile;
-    Rectangle sprite = {
-        .width = 16,
-        .height = 16,
+    Image image;
+    Vector2 spawner;
+
+    Rectangle bar = {
+        .x = 0,
+        .y = game_height() - 10,
+        .width = game_width(),
+        .height = 10,
     };
 
-    // The tile is a square, therefore, have the same size each side. This also
-    // fix a bug of little gaps between some tiles when drawing due the previous
-    // calculation was producing different sizes for each side.
-    //
-    // Previous calculation:
-    //   width = (float) game_width() / data->map.width
-    //   height = (float) game_height() / data->map.height
-    tile.width = tile.height = MIN((float) game_width() / data->map.width,
-        (float) game_height() / data->map.height);
+    // The tiles are squares, the preview is scaled to fit on the screen
+    float tile;
 
     ClearBackground(BLACK);
 
-    tile.y = 0;
-    for (int y = 0; y < data->map.height; y++) {
-        tile.x = 0;
-
-        for (int x = 0; x < data->map.width; x++) {
-            switch (data->generation_stage) {
-            case 0: case 1:
-                draw_layers = 0;
-                if (data->map.tiles[0][y][x] != 0)
-                    DrawRectangleRec(tile, WHITE);
-                break;
-            case 2:
-                draw_layers = 1;
-                break;
-            case 3: case 4: case 5: case 6:
-                draw_layers = 2;
-                break;
-            }
-
-            for (int layer = 0; layer < draw_layers; layer++) {
-                if (tile_empty(data->map.tiles[layer][y][x]))
-                    break;
-
-                sprite.x = tile_x(data->map.tiles[layer][y][x])
-                    * fabs(sprite.width);
-
-                sprite.y = tile_y(data->map.tiles[layer][y][x])
-                    * fabs(sprite.height);
+    if (data->preview.pixels != NULL) {
+        tile = min((float) game_width() / data->preview.width,
+            (float) game_height() / data->preview.height);
+
+        pthread_mutex_lock(&data->preview.lock);
+
+        if (data->preview.texture.id == 0) {
+            image = (Image) {
+                .data = data->preview.pixels,
+                .width = data->preview.width,
+                .height = data->preview.height,
+                .mipmaps = 1,
+                .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8,
+            };
+
+            data->preview.texture = LoadTextureFromImage(image);
+        } else if (data->preview.first_row < data->preview.last_row) {
+            UpdateTextureRec(data->preview.texture, (Rectangle) {
+                    0, data->preview.first_row, data->preview.width,
+                    data->preview.last_row - data->preview.first_row,
+                }, data->preview.pixels
+                    + data->preview.first_row * data->preview.width);
+        }
 
-                if (tile_flipped(data->map.tiles[layer][y][x], 0))
-                    sprite.width = -fabs(sprite.width);
-                else
-                    sprite.width = fabs(sprite.width);
+        data->preview.first_row = data->preview.height;
+        data->preview.last_row = 0;
 
-                if (tile_flipped(data->map.tiles[layer][y][x], 1))
-                    sprite.height = -fabs(sprite.height);
-                else
-                    sprite.height = fabs(sprite.height);
+        DrawTexturePro(data->preview.texture, (Rectangle) {
+                0, 0, data->preview.width, data->preview.height
+            }, (Rectangle) {
+                0, 0, data->preview.width * tile, data->preview.height * tile
+            }, (Vector2) { 0, 0 }, 0, WHITE);
 
-                DrawTexturePro(data->spritesheet, sprite, tile,
-                    (Vector2) { 0, 0 }, 0, WHITE);
-            }
+        for (unsigned i = 0; i < data->preview.spawners_count; i++) {
+            spawner = data->preview.spawners[i];
 
-            if (data->generation_stage == 5)
-                for (unsigned i = 0; i < list_size(data->spawners); i++)
-                    if (list_get(data->spawners, i).position.x == x
-                            && list_get(data->spawners, i).position.y == y)
-                        DrawRectangleRec(tile, BLUE);
-
-            tile.x += tile.width;
+            DrawRectangleRec((Rectangle) {
+                spawner.x * tile, spawner.y * tile, tile, tile
+            }, BLUE);
         }
 
-        tile.y += tile.height;
+        pthread_mutex_unlock(&data->preview.lock);
     }
+
+    bar.width *= progress;
+    DrawRectangleRec(bar, WHITE);
 }
 
-static void genmap_stage0(scene_data_t *data)
+// Start the generation of a new world on its own thread, as it takes longer
+// than the tutorial is shown. Nothing is done when it's already started.
+void genmap_start(void)
 {
-    if (data->generation_steps == 0)
-        data->generation_steps = GENMAP_STEPS_STAGE0;
-
-    for (int y = 0; y < data->map.height; y++) {
-        for (int x = 0; x < data->map.width; x++) {
-            if (((double) rand() / RAND_MAX) <= GENMAP_MAP_LAND_SPAWN_RATE)
-                data->map.tiles[0][y][x] = 1;
-            else
-                data->map.tiles[0][y][x] = 0;
+    if (g_genmap.started)
+        return;
 
-            data->map.tiles[1][y][x] = 0;
-        }
-    }
-}
+    g_genmap.started = true;
 
-static void genmap_stage1(scene_data_t *data)
-{
-    int neighbors;
-    map_t next;
-
-    if (data->generation_steps == 0)
-        data->generation_steps = GENMAP_STEPS_STAGE1;
-
-    map_create(&next, data->map.width, data->map.height);
-
-    for (int y = 0; y < data->map.height; y++) {
-        for (int x = 0; x < data->map.width; x++) {
-            neighbors = stage1_count_neighbors(&data->map, x, y);
-
-            if (x < data->map_border_size || y < data->map_border_size
-                    || x > data->map.width - data->map_border_size
-                    || y > data->map.height - data->map_border_size
-                    || neighbors < 4)
-                next.tiles[0][y][x] = 0;
-            else if (neighbors > 4)
-                next.tiles[0][y][x] = 1;
-            else
-                next.tiles[0][y][x] = data->map.tiles[0][y][x];
-        }
-    }
+    // The palette is read from the GPU, it has to be on the main thread
+    if (!game_headless() && !g_genmap.palette_ready)
+        genmap_load_palette();
 
-    map_destroy(&data->map);
-    data->map = next;
-}
+    g_genmap.data = genmap_create();
 
-static void genmap_stage2(scene_data_t *data)
-{
-#define TEST_NEIGHBORS(must_have, can_have, action)                            \
-    if ((neighbors & (must_have)) == (must_have) && !(neighbors & ~(can_have))) \
-        next.tiles[0][y][x] = (action)
+    atomic_store(&g_genmap.progress,
+        g_genmap.data->new_world ? 0 : WORLDGEN_STAGES * 100);
+    atomic_store(&g_genmap.failed, false);
 
-    int neighbors;
-    map_t next;
+    // The game only exits after the world is saved, or the save would be left
+    // with part of it.
+    if (!g_genmap.exit_registered)
+        g_genmap.exit_registered = atexit(genmap_wait) == 0;
 
-    if (data->generation_steps == 0)
-        data->generation_steps = GENMAP_STEPS_STAGE2;
-    else
-        // Only the first pass on this stage are needed, the others are for see
-        // the result.
+    if (game_headless() || !g_genmap.data->new_world)
         return;
 
-    map_create(&next, data->map.width, data->map.height);
-
-    for (int y = 0; y < data->map.height; y++) {
-        for (int x = 0; x < data->map.width; x++) {
-            if (data->map.tiles[0][y][x] == 0) {
-                neighbors = stage2_find_neighbors(&data->map, x, y);
-                next.tiles[0][y][x] = tile_new(9, 1);
-
-                // Sides
-                TEST_NEIGHBORS(0x02, 0x07, tile_new(9, 0));
-                TEST_NEIGHBORS(0x10, 0x94, tile_new(10, 1));
-                TEST_NEIGHBORS(0x40, 0xE0, tile_new(9, 2));
-                TEST_NEIGHBORS(0x08, 0x29, tile_new(8, 1));
-
-                // Sides double
-                TEST_NEIGHBORS(0x42, 0xE7, tile_new(4, 4));
-                TEST_NEIGHBORS(0x18, 0xBD, tile_new(5, 4));
-
-                // Sides all
-                TEST_NEIGHBORS(0x59, 0xFF, tile_new(6, 4));
-
-                // Sides triple
-                TEST_NEIGHBORS(0x1A, 0xBF, tile_new(6, 0));
-                TEST_NEIGHBORS(0x58, 0xFD, tile_new(7, 0));
-                TEST_NEIGHBORS(0x4A, 0xEF, tile_new(6, 1));
-                TEST_NEIGHBORS(0x52, 0xF7, tile_new(7, 1));
-
-                // Sides corner
-                TEST_NEIGHBORS(0x22, 0x27, tile_new(0, 1));
-                TEST_NEIGHBORS(0x82, 0x87, tile_new(1, 1));
-                TEST_NEIGHBORS(0x41, 0xE1, tile_new(0, 0));
-                TEST_NEIGHBORS(0x44, 0xE4, tile_new(1, 0));
-
-                TEST_NEIGHBORS(0x0C, 0x2D, tile_new(3, 1));
-                TEST_NEIGHBORS(0x88, 0xA9, tile_new(3, 0));
-                TEST_NEIGHBORS(0x11, 0x95, tile_new(2, 1));
-                TEST_NEIGHBORS(0x30, 0xB4, tile_new(2, 0));
-
-                // Sides double corner
-                TEST_NEIGHBORS(0xA2, 0xA7, tile_new(5, 3));
-                TEST_NEIGHBORS(0x31, 0xB5, tile_new(4, 2));
-                TEST_NEIGHBORS(0x45, 0xE5, tile_new(4, 3));
-                TEST_NEIGHBORS(0x8C, 0xAD, tile_new(5, 2));
-
-                // Diagonals
-                TEST_NEIGHBORS(0x0A, 0x2F, tile_new(8, 0));
-                TEST_NEIGHBORS(0x12, 0x97, tile_new(10, 0));
-                TEST_NEIGHBORS(0x50, 0xF4, tile_new(10, 2));
-                TEST_NEIGHBORS(0x48, 0xE9, tile_new(8, 2));
-
-                // Diagonals corner
-                TEST_NEIGHBORS(0x8A, 0xAF, tile_new(6, 2));
-                TEST_NEIGHBORS(0x32, 0xB7, tile_new(7, 2));
-                TEST_NEIGHBORS(0x51, 0xF5, tile_new(7, 3));
-                TEST_NEIGHBORS(0x4C, 0xED, tile_new(6, 3));
-
-                // Corners
-                TEST_NEIGHBORS(0x80, 0x80, tile_new(8, 3));
-                TEST_NEIGHBORS(0x20, 0x20, tile_new(9, 3));
-                TEST_NEIGHBORS(0x04, 0x04, tile_new(8, 4));
-                TEST_NEIGHBORS(0x01, 0x01, tile_new(9, 4));
-
-                // Corners double
-                TEST_NEIGHBORS(0x84, 0x84, tile_new(3, 3));
-                TEST_NEIGHBORS(0x21, 0x21, tile_new(2, 3));
-                TEST_NEIGHBORS(0x05, 0x05, tile_new(3, 4));
-                TEST_NEIGHBORS(0xA0, 0xA0, tile_new(2, 4));
-
-                // Corners opposite double
-                TEST_NEIGHBORS(0x81, 0x81, tile_new(3, 2));
-                TEST_NEIGHBORS(0x24, 0x24, tile_new(2, 2));
-
-                // Corners triple
-                TEST_NEIGHBORS(0x85, 0x85, tile_new(5, 0));
-                TEST_NEIGHBORS(0x25, 0x25, tile_new(4, 0));
-                TEST_NEIGHBORS(0xA4, 0xA4, tile_new(5, 1));
-                TEST_NEIGHBORS(0xA1, 0xA1, tile_new(4, 1));
-
-                // Corners all
-                TEST_NEIGHBORS(0xA5, 0xA5, tile_new(7, 4));
-
-                next.tiles[0][y][x] = tile_collidable(next.tiles[0][y][x]);
-            } else {
-                next.tiles[0][y][x] = tile_new(11, 2);
-            }
-        }
-    }
+    g_genmap.data->background = true;
+    g_genmap.data->workers = workers_create(workers_count(game_workers()));
 
-    map_destroy(&data->map);
-    data->map = next;
+    g_genmap.threaded = pthread_create(&g_genmap.thread, NULL,
+        genmap_generate, g_genmap.data) == 0;
 
-#undef TEST_NEIGHBORS
+    if (!g_genmap.threaded) {
+        workers_destroy(g_genmap.data->workers);
+
+        g_genmap.data->background = false;
+        g_genmap.data->workers = game_workers();
+    }
 }
 
-static void genmap_stage3(scene_data_t *data)
+// Fraction of the generation that is done, 1 when the world is saved
+float genmap_progress(void)
 {
-    int floors_count = 0;
-    int tree_x, tree_y;
-
-    int trees_to_generate;
-    int tree_type;
+    return atomic_load(&g_genmap.progress) / (WORLDGEN_STAGES * 100.0f);
+}
 
-    bool tree_generated;
+static scene_data_t *genmap_create(void)
+{
+    const int width = game_width();
+    const int height = game_height();
 
-    // The total steps is determined by the number of trees that should be
-    // generated.
-    if (data->generation_steps == 0) {
-        for (int y = 0; y < data->map.height; y++)
-            for (int x = 0; x < data->map.width; x++)
-                if (tile_equal(data->map.tiles[0][y][x], tile_new(11, 2)))
-                    floors_count++;
+    int map_width, map_height;
 
-        data->generation_steps = floors_count * GENMAP_TREE_GENERATION_FACTOR;
-    }
+    scene_data_t *data = malloc(sizeof(scene_data_t));
 
-    trees_to_generate = ceil(data->generation_steps * GENMAP_TREE_GENERATION_FACTOR);
-    for (int tree = 0; tree < trees_to_generate; tree++) {
-        tree_generated = false;
+    data->new_world = !map_exists();
 
-        do {
+    data->background = false;
+    data->workers = game_workers();
 
-            tree_x = rand() % data->map.width;
-            tree_y = rand() % data->map.height;
+    data->preview.pixels = NULL;
+    data->preview.spawners = NULL;
+    data->preview.spawners_count = 0;
+    data->preview.texture = (Texture) { 0 };
 
-            if (tile_equal(data->map.tiles[0][tree_y][tree_x], tile_new(11, 2))
-                    && tile_empty(data->map.tiles[1][tree_y - 0][tree_x])
-                    && tile_empty(data->map.tiles[1][tree_y - 1][tree_x]))
-                tree_generated = true;
-        } while (!tree_generated);
+    // There's nothing to generate, only to change to the game scene
+    if (!data->new_world)
+        return data;
 
-        tree_type = rand() % 2;
-        data->map.tiles[1][tree_y - 0][tree_x] = tile_collidable(tile_new(tree_type, 4));
-        data->map.tiles[1][tree_y - 1][tree_x] = tile_new(tree_type, 3);
+    if (width < height) {
+        map_width = GENMAP_MAP_BASE_SIZE;
+        map_height = ((float) height / width) * map_width;
+    } else {
+        map_height = GENMAP_MAP_BASE_SIZE;
+        map_width = ((float) width / height) * map_height;
     }
 
-    data->generation_steps -= trees_to_generate;
-    if (data->generation_steps == 0)
-        data->generation_steps++;
-}
+    // The workers are set when it's known where the generation runs
+    worldgen_create(&data->world, map_width, map_height, game_seed(), NULL);
 
-static void genmap_stage4(scene_data_t *data)
-{
-    int type;
-    tile_t tile;
-
-    if (data->generation_steps == 0)
-        data->generation_steps = GENMAP_STEPS_STAGE4;
-
-    for (int y = 0; y < data->map.height; y++) {
-        for (int x = 0; x < data->map.width; x++) {
-            tile = 0;
-
-            if (!tile_empty(data->map.tiles[1][y][x]))
-                continue;
-
-            if (tile_equal(data->map.tiles[0][y][x], tile_new(11, 2))) {
-                type = rand() % 2;
-
-                if (((double) rand() / RAND_MAX) <= GENMAP_FLOWER_SPAWN_RATE)
-                    tile = tile_new(11, type);
-                else if (((double) rand() / RAND_MAX) <= GENMAP_GRAVESTONE_SPAWN_RATE
-                        && (stage4_count_neighbors(&data->map, x, y,
-                                tile_new(11, 0)) > 2
-                            || stage4_count_neighbors(&data->map, x, y,
-                                tile_new(11, 1)) > 3))
-                    tile = !stage4_count_neighbors(&data->map, x, y,
-                        tile_new(1 - type, 2)) ?
-                        tile_collidable(tile_new(type, 2)) : 0;
-            } else if (tile_equal(data->map.tiles[0][y][x], tile_new(9, 1))) {
-                type = rand() % 2;
-
-                if (((double) rand() / RAND_MAX) <= GENMAP_SINGLE_ROCK_SPAWN_RATE)
-                    tile = tile_new(type + 10, type + 3);
-                else if (((double) rand() / RAND_MAX) <= GENMAP_ROCKS_SPAWN_RATE
-                        && (stage4_count_neighbors(&data->map, x, y,
-                                tile_new(10, 3))
-                            || stage4_count_neighbors(&data->map, x, y,
-                                tile_new(11, 4))))
-                    tile = tile_new(11 - type, 3 + type);
-            }
+    if (!game_headless()) {
+        data->preview.width = map_width;
+        data->preview.height = map_height;
 
-            if (!tile_empty(tile) && rand() % 2)
-                tile = tile_flip(tile, 0);
+        data->preview.first_row = map_height;
+        data->preview.last_row = 0;
 
-            data->map.tiles[1][y][x] = tile;
-        }
+        data->preview.pixels = calloc((size_t) map_width * map_height,
+            sizeof(Color));
+
+        pthread_mutex_init(&data->preview.lock, NULL);
     }
+
+    return data;
 }
 
-/* The fifth generation stage:
- *
- *   On this stage are generated the spawn points of enemies the number of steps
- * aren't pre determined because its how many as possible spawn points to place
- * on the map, therefore, is only stop when isn't possible to place other spawn.
- */
-static void genmap_stage5(scene_data_t *data)
+static void genmap_destroy(scene_data_t *data)
 {
-    if (data->generation_steps == 0) {
-        for (int y = 0; y < data->map.height; y++)
-            for (int x = 0; x < data->map.width; x++)
-                list_add(data->spawn_points, ((Vector2) { x, y }));
+    if (data->new_world)
+        worldgen_destroy(&data->world);
+
+    if (data->background)
+        workers_destroy(data->workers);
+
+    if (data->preview.pixels != NULL) {
+        pthread_mutex_destroy(&data->preview.lock);
 
-        data->generation_steps = 2;
+        free(data->preview.pixels);
+        free(data->preview.spawners);
     }
 
-    stage5_generate_spawners(data, 40);
+    free(data);
 }
 
-static void genmap_stage6(scene_data_t *data)
+static void *genmap_generate(void *data_pointer)
 {
-    Vector2 player_pos = (Vector2) {
-        .x = data->map.width / 2 - 1,
-        .y = data->map.height / 2 - 1,
+    static const char *stage_names[] = {
+        "genmap stage 0", "genmap stage 1", "genmap stage 2", "genmap stage 3",
+        "genmap stage 4", "genmap stage 5", "genmap stage 6", "genmap stage 7",
     };
 
-    if (data->generation_steps == 0)
-        data->generation_steps = GENMAP_STEPS_STAGE6;
+    scene_data_t *data = data_pointer;
+    worldgen_t *world = &data->world;
 
-    if (player_exists())
-        return;
+    const char *stage;
+    bool more;
 
-    while (tile_collision(map_tile(&data->map, 0, player_pos.x, player_pos.y))
-            || tile_collision(map_tile(&data->map, 1, player_pos.x, player_pos.y))) {
-        player_pos.x--;
-        player_pos.y--;
-    }
+    if (!data->new_world)
+        return NULL;
 
-    data->player = player_create(player_pos);
-}
+    world->workers = data->workers;
 
-static int stage1_count_neighbors(map_t *map, int x, int y)
-{
-    int next_x, next_y;
-    int neighbors = 0;
+    while (world->stage < WORLDGEN_STAGES) {
+        stage = stage_names[world->stage];
 
-    for (int offset_y = -1; offset_y <= 1; offset_y++) {
-        next_y = y + offset_y;
+        if (!data->background)
+            stats_begin(stage);
 
-        for (int offset_x = -1; offset_x <= 1; offset_x++) {
-            next_x = x + offset_x;
+        more = worldgen_step(world);
 
-            if (next_x < 0 || next_y < 0 || next_x >= map->width
-                    || next_y >= map->height || (next_x == x && next_y == y))
-                continue;
-            else if (map->tiles[0][next_y][next_x] != 0)
-                neighbors++;
-        }
+        if (!data->background)
+            stats_end(stage);
+
+        genmap_publish(data);
+
+        // The end is only marked after the world is saved
+        if (more)
+            atomic_store(&g_genmap.progress, world->progress);
     }
 
-    return neighbors;
+    if (genmap_save(data))
+        atomic_store(&g_genmap.progress, WORLDGEN_STAGES * 100);
+    else
+        atomic_store(&g_genmap.failed, true);
+
+    return NULL;
 }
 
-static int stage2_find_neighbors(map_t *map, int x, int y)
+static bool genmap_save(scene_data_t *data)
 {
-    int neighbors = 0;
-    int bit = 0;
-    int next_x, next_y;
+    FILE *file;
 
-    for (int offset_y = -1; offset_y <= 1; offset_y++) {
-        next_y = y + offset_y;
+    // The world is new, all that was on the save belonged to other world. It
+    // only replaces the save once it's complete.
+    if ((file = game_file_replace()) == NULL)
+        return false;
 
-        for (int offset_x = -1; offset_x <= 1; offset_x++) {
-            next_x = x + offset_x;
+    worldgen_save(&data->world, file);
 
-            if (next_x < 0 || next_y < 0 || next_x >= map->width
-                    || next_y >= map->height || (next_x == x && next_y == y))
-                continue;
-            else if (map->tiles[0][next_y][next_x] != 0)
-                neighbors |= 1 << bit;
+    return game_file_commit(file);
+}
 
-            bit++;
-        }
-    }
+static void genmap_wait(void)
+{
+    if (!g_genmap.started)
+        return;
 
-    return neighbors;
+    if (g_genmap.threaded)
+        pthread_join(g_genmap.thread, NULL);
+
+    genmap_destroy(g_genmap.data);
+
+    g_genmap.data = NULL;
+    g_genmap.started = g_genmap.threaded = false;
 }
 
-static int stage4_count_neighbors(map_t *map, int x, int y, tile_t tile)
+static void genmap_publish(scene_data_t *data)
 {
-    int next_x, next_y;
-    int neighbors = 0;
+    const worldgen_t *world = &data->world;
+    Color *row;
 
-    for (int offset_y = -1; offset_y <= 1; offset_y++) {
-        next_y = y + offset_y;
+    if (data->preview.pixels == NULL)
+        return;
 
-        for (int offset_x = -1; offset_x <= 1; offset_x++) {
-            next_x = x + offset_x;
+    pthread_mutex_lock(&data->preview.lock);
 
-            if (next_x < 0 || next_y < 0 || next_x >= map->width
-                    || next_y >= map->height || (next_x == x && next_y == y))
-                continue;
-            else if (tile_equal(map->tiles[1][next_y][next_x], tile))
-                neighbors++;
-        }
+    for (int y = world->changed_first; y < world->changed_last; y++) {
+        row = data->preview.pixels + y * data->preview.width;
+
+        for (int x = 0; x < data->preview.width; x++)
+            row[x] = genmap_tile_color(world->map.tiles[0][y][x],
+                world->map.tiles[1][y][x]);
+    }
+
+    if (world->changed_first < world->changed_last) {
+        data->preview.first_row = min(data->preview.first_row,
+            world->changed_first);
+        data->preview.last_row = max(data->preview.last_row,
+            world->changed_last);
     }
 
-    return neighbors;
+    // The spawners are only added, never removed
+    if (world->spawners_count > data->preview.spawners_count) {
+        data->preview.spawners = realloc(data->preview.spawners,
+            sizeof(Vector2) * world->spawners_count);
+
+        for (unsigned i = data->preview.spawners_count;
+                i < world->spawners_count; i++)
+            data->preview.spawners[i] = world->spawners[i];
+
+        data->preview.spawners_count = world->spawners_count;
+    }
+
+    pthread_mutex_unlock(&data->preview.lock);
 }
 
-static void stage5_generate_spawners(scene_data_t *data, int spawners)
+static void genmap_load_palette(void)
 {
-    Vector2 point;
-    Vector2 spawner_position;
+    Image tiles = LoadImageFromTexture(game_get_texture("tiles"));
+    Color *colors = LoadImageColors(tiles);
+    Color color;
 
-    bool is_valid_point = false;
-    int point_number;
+    int rows = min(tiles.height / GENMAP_SPRITE_SIZE, GENMAP_PALETTE_ROWS);
+    int columns = min(tiles.width / GENMAP_SPRITE_SIZE, GENMAP_PALETTE_COLUMNS);
 
-    if (spawners == 0 || list_size(data->spawn_points) == 0)
-        return;
+    unsigned long sum[3], weight;
+
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            sum[0] = sum[1] = sum[2] = weight = 0;
 
-    while (!is_valid_point && list_size(data->spawn_points) > 0) {
-        point_number = rand() % list_size(data->spawn_points);
-        point = list_get(data->spawn_points, point_number);
+            // Weighted by the alpha, so the transparent parts don't count
+            for (int y = 0; y < GENMAP_SPRITE_SIZE; y++) {
+                for (int x = 0; x < GENMAP_SPRITE_SIZE; x++) {
+                    color = colors[(row * GENMAP_SPRITE_SIZE + y) * tiles.width
+                        + column * GENMAP_SPRITE_SIZE + x];
 
-        is_valid_point = true;
-        for (unsigned i = 0; i < list_size(data->spawners); i++) {
-            spawner_position = list_get(data->spawners, i).position;
+                    sum[0] += color.r * color.a;
+                    sum[1] += color.g * color.a;
+                    sum[2] += color.b * color.a;
 
-            if (pow(point.x - spawner_position.x, 2)
-                    + pow(point.y - spawner_position.y, 2)
-                    < pow(SPAWNER_DISTANCE_RADIUS, 2)) {
-                is_valid_point = false;
-                break;
+                    weight += color.a;
+                }
             }
+
+            g_genmap.palette[row][column] = weight == 0 ? BLACK : (Color) {
+                sum[0] / weight, sum[1] / weight, sum[2] / weight, 255
+            };
         }
+    }
 
-        list_remove(data->spawn_points, point_number);
+    UnloadImageColors(colors);
+    UnloadImage(tiles);
 
-        if (!is_valid_point)
-            continue;
+    g_genmap.palette_ready = true;
+}
 
-        spawner_new(&data->spawners, point);
-        data->generation_steps = 2;
-    }
+static Color genmap_tile_color(tile_t ground, tile_t decoration)
+{
+    tile_t tile = tile_empty(decoration) ? ground : decoration;
 
-    stage5_generate_spawners(data, spawners - 1);
-}
+    // Before the stage 2 the ground is only land or water
+    if (tile_empty(ground))
+        return ground != 0 ? WHITE : BLACK;
+
+    if (tile_y(tile) >= GENMAP_PALETTE_ROWS
+            || tile_x(tile) >= GENMAP_PALETTE_COLUMNS)
+        return MAGENTA;
 
+    return g_genmap.palette[tile_y(tile)][tile_x(tile)];
+}
@@ -23,18 +23,29 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "game.h"
 #include "scene.h"
 #define NUM_FRAMES  3
+
+// Seconds that the tutorial is shown, the world is generated meanwhile
+#define TUTORIAL_TIME 5.0
+
 static Font alagard;
+static double tutorial_start;
+
 scene_data_t *tutorial_init(void) {
     alagard = LoadFont("custom_alagard.png");
  setlocale(LC_ALL,"portuguese");
+
+    tutorial_start = game_time();
+    genmap_start();
+
     return NULL;
 }
 
 void tutorial_update(void *data){
-                WaitTime(5000);
-             game_set_scene("genmap");
-
+    (void) data;
 
+    // The genmap scene shows the rest of the generation, if there's any
+    if (game_time() - tutorial_start >= TUTORIAL_TIME)
+        game_set_scene("genmap");
 }
 
 void tutorial_draw(void *data)
@@ -52,7 +63,8 @@ void tutorial_draw(void *data)
     DrawRectangleGradientV(0, 0, 1280, 720, GetColor(0x038c7fff), GOLD);
     //AMARELO 0xfeae34fff
 ///DRAW INFORMATIONS
-     DrawTextEx(alagard,"LOADING... ", (Vector2) { 10, 50 }, 20, -1, BLACK);
+     DrawTextEx(alagard, TextFormat("LOADING... %d%%",
+        (int) (genmap_progress() * 100)), (Vector2) { 10, 50 }, 20, -1, BLACK);
       DrawTextEx(alagard,"HOW PLAY?", (Vector2) { 400, 50 }, 75, -1, GOLD);
       DrawTextEx(alagard,"1-ADVENTURE is an  ", (Vector2) { 10, 520 }, 30, -1, WHITE);
       DrawTextEx(alagard,"action and adventure ", (Vector2) { 10, 550 }, 30, -1, WHITE);
@@ -0,0 +1,336 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils/stats.h"
+#include "utils/workers.h"
+#include "world/map/worldgen.h"
+
+// Map size of the game at 1280x720
+#define WORLDGEN_DEFAULT_WIDTH  533
+#define WORLDGEN_DEFAULT_HEIGHT 300
+
+typedef struct {
+    int width;
+    int height;
+
+    unsigned    seed;
+    const char *output;
+
+    // Generate straight to the files, with only a few bands on memory
+    bool stream;
+
+    // Save all the tiles of the maps instead of their seeds, and load the maps
+    // back from the files.
+    bool layers;
+    bool load;
+
+    // Result of each seed, from the first one
+    struct {
+        double times[WORLDGEN_STAGES];
+        double total;
+
+        unsigned spawners;
+        bool     saved;
+
+        // Time to load the map back and size of the save
+        double load;
+        long   size;
+    } *results;
+
+    // Only one world generated at time is split in rows
+    workers_t *workers;
+} tool_job_t;
+
+static void tool_generate(void *job, unsigned worker, unsigned first,
+    unsigned last);
+static bool tool_load(tool_job_t *job, unsigned i, const char *filename);
+static bool tool_pattern(const char *pattern);
+static bool tool_count(const char *text, unsigned *count);
+static void tool_filename(char *filename, size_t size, const char *pattern,
+    unsigned seed);
+static void tool_usage(const char *name);
+
+int main(int argc, char *argv[])
+{
+    tool_job_t job = {
+        .width = WORLDGEN_DEFAULT_WIDTH,
+        .height = WORLDGEN_DEFAULT_HEIGHT,
+        .seed = 0,
+        .output = "world-%u.sav",
+    };
+
+    unsigned seeds = 1;
+    unsigned threads = workers_cpu_count();
+
+    double totals[WORLDGEN_STAGES] = { 0 };
+    double total = 0;
+    int failed = 0;
+
+    workers_t *workers;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &job.width, &job.height) != 2
+                    || job.width < 1 || job.height < 1) {
+                tool_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            job.seed = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) {
+            if (!tool_count(argv[++i], &seeds)) {
+                tool_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            if (!tool_count(argv[++i], &threads)) {
+                tool_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            job.output = argv[++i];
+
+            if (!tool_pattern(job.output)) {
+                tool_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            job.stream = true;
+        } else if (strcmp(argv[i], "--layers") == 0) {
+            job.layers = true;
+        } else if (strcmp(argv[i], "--load") == 0) {
+            job.load = true;
+        } else {
+            tool_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    job.results = calloc(seeds, sizeof(*job.results));
+    workers = workers_create(threads);
+
+    // Many worlds run one on each worker, a single one is split in rows
+    if (seeds == 1) {
+        job.workers = workers;
+        tool_generate(&job, 0, 0, 1);
+    } else {
+        job.workers = NULL;
+        workers_run(workers, seeds, tool_generate, &job);
+    }
+
+    workers_destroy(workers);
+
+    printf("%-10s", "seed");
+    for (int stage = 0; stage < WORLDGEN_STAGES; stage++)
+        printf(" %11s", worldgen_stage_name(stage));
+    printf(" %11s %8s", "total", "spawners");
+    if (job.load)
+        printf(" %11s %10s", "load", "bytes");
+    printf("\n");
+
+    for (unsigned i = 0; i < seeds; i++) {
+        printf("%-10u", job.seed + i);
+
+        for (int stage = 0; stage < WORLDGEN_STAGES; stage++) {
+            printf(" %9.3fms", job.results[i].times[stage] * 1000);
+            totals[stage] += job.results[i].times[stage];
+        }
+
+        printf(" %9.3fms %8u", job.results[i].total * 1000,
+            job.results[i].spawners);
+        if (job.load)
+            printf(" %9.3fms %10ld", job.results[i].load * 1000,
+                job.results[i].size);
+        printf("%s\n", job.results[i].saved ? "" : " not saved");
+
+        total += job.results[i].total;
+        failed += !job.results[i].saved;
+    }
+
+    // The mean of each stage when there's more than one world
+    if (seeds > 1) {
+        printf("%-10s", "mean");
+
+        for (int stage = 0; stage < WORLDGEN_STAGES; stage++)
+            printf(" %9.3fms", totals[stage] * 1000 / seeds);
+
+        printf(" %9.3fms\n", total * 1000 / seeds);
+    }
+
+    free(job.results);
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static void tool_generate(void *job_pointer, unsigned worker, unsigned first,
+    unsigned last)
+{
+    tool_job_t *job = job_pointer;
+    worldgen_t world;
+
+    char filename[4096];
+    FILE *file;
+
+    (void) worker;
+
+    for (unsigned i = first; i < last; i++) {
+        tool_filename(filename, sizeof(filename), job->output, job->seed + i);
+
+        if ((file = fopen(filename, "wb")) == NULL) {
+            fprintf(stderr, "Couldn't save the world on %s\n", filename);
+            continue;
+        }
+
+        if (job->stream) {
+            job->results[i].spawners = worldgen_stream(&world, job->width,
+                job->height, job->seed + i, job->workers, file);
+        } else {
+            worldgen_create(&world, job->width, job->height, job->seed + i,
+                job->workers);
+            worldgen_run(&world);
+
+            if (job->layers)
+                world.map.generator = 0;
+
+            worldgen_save(&world, file);
+
+            job->results[i].spawners = world.spawners_count;
+        }
+
+        for (int stage = 0; stage < WORLDGEN_STAGES; stage++) {
+            job->results[i].times[stage] = world.times[stage];
+            job->results[i].total += world.times[stage];
+        }
+
+        job->results[i].saved = !ferror(file);
+        job->results[i].saved &= fclose(file) == 0;
+
+        if (!job->results[i].saved)
+            fprintf(stderr, "Couldn't save the world on %s\n", filename);
+        else if (job->load && !tool_load(job, i, filename))
+            fprintf(stderr, "Couldn't load the world from %s\n", filename);
+
+        worldgen_destroy(&world);
+    }
+}
+
+// Load the map as the game does, reading the layers or making them again
+static bool tool_load(tool_job_t *job, unsigned i, const char *filename)
+{
+    map_t map = { 0 };
+    bool loaded = true;
+    bool dimensions;
+
+    double start = stats_now();
+
+    FILE *file;
+
+    if ((file = fopen(filename, "rb")) == NULL)
+        return false;
+
+    for (int what_load = MAP_LOAD_DIMENSIONS; what_load <= MAP_LOAD_LAYER_1;
+            what_load++) {
+        fseek(file, 0, SEEK_SET);
+        loaded = loaded && map_read(&map, file, what_load);
+
+        if (what_load == MAP_LOAD_DIMENSIONS)
+            dimensions = loaded;
+
+        if (loaded && what_load == MAP_LOAD_LAYER_0 && map.generator != 0)
+            loaded = worldgen_terrain(&map, job->workers);
+    }
+
+    job->results[i].load = stats_now() - start;
+
+    fseek(file, 0, SEEK_END);
+    job->results[i].size = ftell(file);
+    fclose(file);
+
+    // Some layers can be missing when it failed after the dimensions
+    if (dimensions)
+        map_destroy(&map);
+
+    return loaded;
+}
+
+// The pattern must have a single %u and no other %, it's never used as a
+// format string.
+static bool tool_pattern(const char *pattern)
+{
+    const char *seed = strchr(pattern, '%');
+
+    return seed != NULL && seed[1] == 'u' && strchr(seed + 1, '%') == NULL;
+}
+
+// A count has only digits and isn't 0
+static bool tool_count(const char *text, unsigned *count)
+{
+    char *end;
+    unsigned long value;
+
+    if (*text < '0' || *text > '9')
+        return false;
+
+    errno = 0;
+    value = strtoul(text, &end, 10);
+
+    if (*end != '\0' || errno != 0 || value == 0 || value > UINT_MAX)
+        return false;
+
+    *count = value;
+    return true;
+}
+
+static void tool_filename(char *filename, size_t size, const char *pattern,
+    unsigned seed)
+{
+    const char *at = strchr(pattern, '%');
+
+    snprintf(filename, size, "%.*s%u%s", (int) (at - pattern), pattern, seed,
+        at + 2);
+}
+
+static void tool_usage(const char *name)
+{
+    fprintf(stderr,
+        "Usage: %s [--size WIDTHxHEIGHT] [--seed SEED] [--seeds COUNT]\n"
+        "          [--threads COUNT] [--output PATTERN] [--stream]\n"
+        "          [--layers] [--load]\n"
+        "\n"
+        "Generate the worlds of the seeds SEED to SEED + COUNT - 1 on the\n"
+        "files of the pattern, that has a single %%u for the seed and no\n"
+        "other %% (world-%%u.sav), and print the time of each stage.\n"
+        "Default size %dx%d.\n"
+        "\n"
+        "The maps are saved as their seed, with --layers all their tiles are\n"
+        "saved instead. With --stream the worlds are made a band of rows at\n"
+        "time and saved with all the tiles. The memory doesn't grow with\n"
+        "their height, but the bands are as wide as the world and the\n"
+        "spawners and the regions are kept until the end. With --load each\n"
+        "map is loaded back as the game does and the time and the size of\n"
+        "the save are printed.\n",
+        name, WORLDGEN_DEFAULT_WIDTH, WORLDGEN_DEFAULT_HEIGHT);
+}
@@ -0,0 +1,329 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils/fastmath.h"
+#include "utils/random.h"
+#include "utils/stats.h"
+#include "utils/utils.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#define FASTMATH_BENCHMARK_COUNT (1 << 20)
+
+// Minimax polynomial of atan on [0, 1]
+#define FASTMATH_ATAN_1  0.99997726f
+#define FASTMATH_ATAN_3  -0.33262347f
+#define FASTMATH_ATAN_5  0.19354346f
+#define FASTMATH_ATAN_7  -0.11643287f
+#define FASTMATH_ATAN_9  0.05265332f
+#define FASTMATH_ATAN_11 -0.01172120f
+
+// Minimax polynomials of sin and cos on [-pi/4, pi/4], from Cephes
+#define FASTMATH_SIN_3 -1.6666654611e-1f
+#define FASTMATH_SIN_5 8.3321608736e-3f
+#define FASTMATH_SIN_7 -1.9515295891e-4f
+#define FASTMATH_COS_4 4.166664568298827e-2f
+#define FASTMATH_COS_6 -1.388731625493765e-3f
+#define FASTMATH_COS_8 2.443315711809948e-5f
+
+// pi / 2 split on two floats, the second one keeps the bits the first loses
+#define FASTMATH_PI_2_HIGH 1.5707963705062866f
+#define FASTMATH_PI_2_LOW  -4.371139000186243e-08f
+
+// Adding and subtracting 1.5 * 2^23 rounds to the nearest integer, floorf()
+// isn't an instruction before SSE4.1.
+#define FASTMATH_ROUND 12582912.0f
+
+// The batches run 4 lanes at once on SSE2 and the remaining ones through the
+// scalar functions, both do the same operations in the same order so their
+// results are the same.
+static inline float fastmath_atan2_inline(float y, float x);
+static inline void fastmath_sincos_inline(float angle, float *sine,
+    float *cosine);
+
+float fastmath_atan2(float y, float x)
+{ return fastmath_atan2_inline(y, x); }
+
+float fastmath_angle(float x, float y)
+{
+    const float angle = fastmath_atan2_inline(y, x);
+
+    return angle < 0 ? angle + (float) (UTILS_PI * 2) : angle;
+}
+
+void fastmath_sincos(float angle, float *sine, float *cosine)
+{ fastmath_sincos_inline(angle, sine, cosine); }
+
+Vector2 fastmath_unit(float angle)
+{
+    Vector2 unit;
+
+    fastmath_sincos_inline(angle, &unit.y, &unit.x);
+
+    return unit;
+}
+
+void fastmath_angle_batch(const float *x, const float *y, float *angles,
+    unsigned count)
+{
+    unsigned i = 0;
+
+#if defined(__SSE2__)
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 ax = _mm_andnot_ps(sign, vx);
+        __m128 ay = _mm_andnot_ps(sign, vy);
+
+        __m128 ratio = _mm_div_ps(_mm_min_ps(ax, ay),
+            _mm_max_ps(_mm_max_ps(ax, ay), _mm_set1_ps(FLT_MIN)));
+        __m128 r2 = _mm_mul_ps(ratio, ratio);
+        __m128 angle, mask;
+
+        angle = _mm_add_ps(_mm_set1_ps(FASTMATH_ATAN_9),
+            _mm_mul_ps(r2, _mm_set1_ps(FASTMATH_ATAN_11)));
+        angle = _mm_add_ps(_mm_set1_ps(FASTMATH_ATAN_7), _mm_mul_ps(r2, angle));
+        angle = _mm_add_ps(_mm_set1_ps(FASTMATH_ATAN_5), _mm_mul_ps(r2, angle));
+        angle = _mm_add_ps(_mm_set1_ps(FASTMATH_ATAN_3), _mm_mul_ps(r2, angle));
+        angle = _mm_add_ps(_mm_set1_ps(FASTMATH_ATAN_1), _mm_mul_ps(r2, angle));
+        angle = _mm_mul_ps(ratio, angle);
+
+        mask = _mm_cmpgt_ps(ay, ax);
+        angle = _mm_or_ps(_mm_andnot_ps(mask, angle), _mm_and_ps(mask,
+            _mm_sub_ps(_mm_set1_ps((float) (UTILS_PI / 2)), angle)));
+
+        mask = _mm_cmplt_ps(vx, zero);
+        angle = _mm_or_ps(_mm_andnot_ps(mask, angle), _mm_and_ps(mask,
+            _mm_sub_ps(_mm_set1_ps((float) UTILS_PI), angle)));
+
+        angle = _mm_xor_ps(angle, _mm_and_ps(_mm_cmplt_ps(vy, zero), sign));
+
+        mask = _mm_cmplt_ps(angle, zero);
+        angle = _mm_add_ps(angle,
+            _mm_and_ps(mask, _mm_set1_ps((float) (UTILS_PI * 2))));
+
+        _mm_storeu_ps(angles + i, angle);
+    }
+#endif // __SSE2__
+
+    for (; i < count; i++)
+        angles[i] = fastmath_angle(x[i], y[i]);
+}
+
+void fastmath_sincos_batch(const float *angles, float *sines,
+    float *cosines, unsigned count)
+{
+    unsigned i = 0;
+
+#if defined(__SSE2__)
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 angle = _mm_loadu_ps(angles + i);
+        __m128 quadrant = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(angle,
+            _mm_set1_ps((float) (2 / UTILS_PI))),
+            _mm_set1_ps(FASTMATH_ROUND)), _mm_set1_ps(FASTMATH_ROUND));
+        __m128 r = _mm_sub_ps(_mm_sub_ps(angle,
+            _mm_mul_ps(quadrant, _mm_set1_ps(FASTMATH_PI_2_HIGH))),
+            _mm_mul_ps(quadrant, _mm_set1_ps(FASTMATH_PI_2_LOW)));
+        __m128 r2 = _mm_mul_ps(r, r);
+        __m128i q = _mm_cvttps_epi32(quadrant);
+        __m128 s, c, swap, sine, cosine;
+
+        s = _mm_add_ps(_mm_set1_ps(FASTMATH_SIN_5),
+            _mm_mul_ps(r2, _mm_set1_ps(FASTMATH_SIN_7)));
+        s = _mm_add_ps(_mm_set1_ps(FASTMATH_SIN_3), _mm_mul_ps(r2, s));
+        s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+
+        c = _mm_add_ps(_mm_set1_ps(FASTMATH_COS_6),
+            _mm_mul_ps(r2, _mm_set1_ps(FASTMATH_COS_8)));
+        c = _mm_add_ps(_mm_set1_ps(FASTMATH_COS_4), _mm_mul_ps(r2, c));
+        c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1),
+            _mm_mul_ps(_mm_set1_ps(0.5f), r2)),
+            _mm_mul_ps(_mm_mul_ps(r2, r2), c));
+
+        swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+        sine = _mm_or_ps(_mm_andnot_ps(swap, s), _mm_and_ps(swap, c));
+        cosine = _mm_or_ps(_mm_andnot_ps(swap, c), _mm_and_ps(swap, s));
+
+        sine = _mm_xor_ps(sine, _mm_and_ps(sign, _mm_castsi128_ps(
+            _mm_cmpeq_epi32(_mm_and_si128(q, two), two))));
+        cosine = _mm_xor_ps(cosine, _mm_and_ps(sign, _mm_castsi128_ps(
+            _mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(q, one), two),
+                two))));
+
+        _mm_storeu_ps(sines + i, sine);
+        _mm_storeu_ps(cosines + i, cosine);
+    }
+#endif // __SSE2__
+
+    for (; i < count; i++)
+        fastmath_sincos_inline(angles[i], sines + i, cosines + i);
+}
+
+void fastmath_benchmark(FILE *file)
+{
+    float *x = malloc(sizeof(float) * FASTMATH_BENCHMARK_COUNT);
+    float *y = malloc(sizeof(float) * FASTMATH_BENCHMARK_COUNT);
+    float *angles = malloc(sizeof(float) * FASTMATH_BENCHMARK_COUNT);
+    float *sines = malloc(sizeof(float) * FASTMATH_BENCHMARK_COUNT);
+    float *cosines = malloc(sizeof(float) * FASTMATH_BENCHMARK_COUNT);
+
+    double start, libm_time, fast_time, batch_time;
+    double error, angle_error = 0, sine_error = 0, cosine_error = 0;
+
+    random_t random;
+
+    // The directions of the game, on [0, 2pi), and vectors of any length
+    random_seed(&random, 1, RANDOM_STREAM_AI);
+
+    for (unsigned i = 0; i < FASTMATH_BENCHMARK_COUNT; i++) {
+        x[i] = (random_float(&random) - 0.5f) * 64;
+        y[i] = (random_float(&random) - 0.5f) * 64;
+    }
+
+    start = stats_now();
+    for (unsigned i = 0; i < FASTMATH_BENCHMARK_COUNT; i++)
+        angles[i] = vec2ang(x[i], y[i]);
+    libm_time = stats_now() - start;
+
+    start = stats_now();
+    for (unsigned i = 0; i < FASTMATH_BENCHMARK_COUNT; i++)
+        sines[i] = fastmath_angle(x[i], y[i]);
+    fast_time = stats_now() - start;
+
+    start = stats_now();
+    fastmath_angle_batch(x, y, cosines, FASTMATH_BENCHMARK_COUNT);
+    batch_time = stats_now() - start;
+
+    for (unsigned i = 0; i < FASTMATH_BENCHMARK_COUNT; i++) {
+        // The same direction can be near to 0 on one and near to 2pi on the
+        // other.
+        error = fabs(atan2(sin(sines[i] - angles[i]),
+            cos(sines[i] - angles[i])));
+        angle_error = max(angle_error, error);
+
+        if (sines[i] != cosines[i])
+            angle_error = INFINITY;
+    }
+
+    fprintf(file, "%-10s %12s %12s %12s %12s\n", "function", "libm (ns)",
+        "fast (ns)", "batch (ns)", "max error");
+    fprintf(file, "%-10s %12.2f %12.2f %12.2f %12.3g\n", "angle",
+        libm_time * 1e9 / FASTMATH_BENCHMARK_COUNT,
+        fast_time * 1e9 / FASTMATH_BENCHMARK_COUNT,
+        batch_time * 1e9 / FASTMATH_BENCHMARK_COUNT, angle_error);
+
+    for (unsigned i = 0; i < FASTMATH_BENCHMARK_COUNT; i++)
+        angles[i] = random_float(&random) * (float) (UTILS_PI * 2);
+
+    start = stats_now();
+    for (unsigned i = 0; i < FASTMATH_BENCHMARK_COUNT; i++) {
+        x[i] = cosf(angles[i]);
+        y[i] = sinf(angles[i]);
+    }
+    libm_time = stats_now() - start;
+
+    start = stats_now();
+    for (unsigned i = 0; i < FASTMATH_BENCHMARK_COUNT; i++)
+        fastmath_sincos(angles[i], sines + i, cosines + i);
+    fast_time = stats_now() - start;
+
+    for (unsigned i = 0; i < FASTMATH_BENCHMARK_COUNT; i++) {
+        sine_error = max(sine_error, fabs(sines[i] - sin(angles[i])));
+        cosine_error = max(cosine_error, fabs(cosines[i] - cos(angles[i])));
+    }
+
+    start = stats_now();
+    fastmath_sincos_batch(angles, x, y, FASTMATH_BENCHMARK_COUNT);
+    batch_time = stats_now() - start;
+
+    for (unsigned i = 0; i < FASTMATH_BENCHMARK_COUNT; i++)
+        if (x[i] != sines[i] || y[i] != cosines[i])
+            sine_error = INFINITY;
+
+    fprintf(file, "%-10s %12.2f %12.2f %12.2f %12.3g\n", "sincos",
+        libm_time * 1e9 / FASTMATH_BENCHMARK_COUNT,
+        fast_time * 1e9 / FASTMATH_BENCHMARK_COUNT,
+        batch_time * 1e9 / FASTMATH_BENCHMARK_COUNT,
+        max(sine_error, cosine_error));
+
+    free(cosines);
+    free(sines);
+    free(angles);
+    free(y);
+    free(x);
+}
+
+static inline float fastmath_atan2_inline(float y, float x)
+{
+    const float ax = fabsf(x);
+    const float ay = fabsf(y);
+
+    // The ratio stays on [0, 1], where the polynomial is fit, and the octant
+    // is restored after it. The division by at least FLT_MIN makes (0, 0) an
+    // angle of 0.
+    const float ratio = min(ax, ay) / max(max(ax, ay), FLT_MIN);
+    const float r2 = ratio * ratio;
+
+    float angle = ratio * (FASTMATH_ATAN_1 + r2 * (FASTMATH_ATAN_3
+        + r2 * (FASTMATH_ATAN_5 + r2 * (FASTMATH_ATAN_7
+        + r2 * (FASTMATH_ATAN_9 + r2 * FASTMATH_ATAN_11)))));
+
+    angle = ay > ax ? (float) (UTILS_PI / 2) - angle : angle;
+    angle = x < 0 ? (float) UTILS_PI - angle : angle;
+
+    return y < 0 ? -angle : angle;
+}
+
+static inline void fastmath_sincos_inline(float angle, float *sine,
+    float *cosine)
+{
+    // Reduce to r on [-pi/4, pi/4] and the quadrant of the angle
+    const float quadrant = (angle * (float) (2 / UTILS_PI) + FASTMATH_ROUND)
+        - FASTMATH_ROUND;
+    const float r = (angle - quadrant * FASTMATH_PI_2_HIGH)
+        - quadrant * FASTMATH_PI_2_LOW;
+    const float r2 = r * r;
+    const int q = (int) quadrant;
+
+    const float s = r + r * r2 * (FASTMATH_SIN_3
+        + r2 * (FASTMATH_SIN_5 + r2 * FASTMATH_SIN_7));
+    const float c = 1 - 0.5f * r2 + r2 * r2 * (FASTMATH_COS_4
+        + r2 * (FASTMATH_COS_6 + r2 * FASTMATH_COS_8));
+
+    // sin and cos swap on the odd quadrants and change their signs on the
+    // halves of the circle where they are negative.
+    const float swapped_sine = q & 1 ? c : s;
+    const float swapped_cosine = q & 1 ? s : c;
+
+    *sine = q & 2 ? -swapped_sine : swapped_sine;
+    *cosine = (q + 1) & 2 ? -swapped_cosine : swapped_cosine;
+}
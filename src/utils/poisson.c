@@ -0,0 +1,240 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "raylib.h"
+#include "utils/poisson.h"
+#include "utils/random.h"
+#include "utils/utils.h"
+
+// Cells of the grid around the one of a candidate that can have samples
+// closer than the radius, and the padding of the grid so they're never out
+#define POISSON_REACH 2
+
+// Position of the empty cells of the grid, far enough to never be too close
+#define POISSON_EMPTY -1.0e9f
+
+typedef struct {
+    const bool *mask;
+    int width;
+    int height;
+
+    float radius;
+
+    // Background grid with cells of radius / sqrt(2), so a cell holds one
+    // sample at most, its position is copied here to test the candidates
+    // without going to the samples.
+    Vector2 *grid;
+    int      grid_width;
+    int      grid_height;
+    float    cell;
+
+    Vector2 *samples;
+    unsigned count;
+
+    // Samples that can still have neighbors around them
+    unsigned *active;
+    unsigned  active_count;
+} poisson_t;
+
+static Vector2 *poisson_cell(poisson_t *poisson, int x, int y);
+static bool poisson_fits(poisson_t *poisson, int x, int y);
+static void poisson_add(poisson_t *poisson, int x, int y);
+static void poisson_grow(poisson_t *poisson, random_t *random);
+
+unsigned poisson_sample(random_t *random, const bool *mask, int width,
+    int height, float radius, Vector2 **samples)
+{
+    return poisson_sample_around(random, mask, width, height, radius, NULL, 0,
+        samples);
+}
+
+unsigned poisson_sample_around(random_t *random, const bool *mask, int width,
+    int height, float radius, const Vector2 *fixed, unsigned fixed_count,
+    Vector2 **samples)
+{
+    poisson_t poisson = {
+        .mask = mask,
+        .width = width,
+        .height = height,
+    };
+
+    unsigned cells;
+    int x, y;
+
+    // The samples are cells, two of them are always at least one apart
+    poisson.radius = max(radius, 1);
+    poisson.cell = poisson.radius / sqrtf(2);
+
+    poisson.grid_width = ceilf(width / poisson.cell) + POISSON_REACH * 2;
+    poisson.grid_height = ceilf(height / poisson.cell) + POISSON_REACH * 2;
+
+    cells = poisson.grid_width * poisson.grid_height;
+    poisson.grid = malloc(sizeof(Vector2) * cells);
+
+    for (unsigned i = 0; i < cells; i++)
+        poisson.grid[i] = (Vector2) { POISSON_EMPTY, POISSON_EMPTY };
+
+    // The fixed samples are only on the grid, the ones that are out of it are
+    // too far to be closer than the radius of any cell of the mask.
+    for (unsigned i = 0; i < fixed_count; i++) {
+        x = floorf(fixed[i].x);
+        y = floorf(fixed[i].y);
+
+        if (x > -poisson.radius && y > -poisson.radius
+                && x < width + poisson.radius && y < height + poisson.radius)
+            *poisson_cell(&poisson, x, y) = (Vector2) { x, y };
+    }
+
+    // Each sample is active at most once
+    poisson.samples = malloc(sizeof(Vector2) * cells);
+    poisson.active = malloc(sizeof(unsigned) * cells);
+
+    // The samples only grow over the cells that are reachable from the first,
+    // the empty cells of the grid take a few tries each to start others on the
+    // parts of the mask that are apart, as islands. Most of the empty cells are
+    // out of the mask or too close of a sample, the tries are kept few.
+    for (int cell_y = 0; cell_y * poisson.cell < height; cell_y++) {
+        for (int cell_x = 0; cell_x * poisson.cell < width; cell_x++) {
+            if (poisson.grid[(cell_y + POISSON_REACH) * poisson.grid_width
+                    + cell_x + POISSON_REACH].x != POISSON_EMPTY)
+                continue;
+
+            for (int attempt = 0; attempt < POISSON_SEED_ATTEMPTS; attempt++) {
+                x = (cell_x + random_float(random)) * poisson.cell;
+                y = (cell_y + random_float(random)) * poisson.cell;
+
+                if (x >= width || y >= height || !mask[y * width + x]
+                        || !poisson_fits(&poisson, x, y))
+                    continue;
+
+                poisson_add(&poisson, x, y);
+                poisson_grow(&poisson, random);
+
+                break;
+            }
+        }
+    }
+
+    free(poisson.grid);
+    free(poisson.active);
+
+    *samples = poisson.samples;
+
+    return poisson.count;
+}
+
+static Vector2 *poisson_cell(poisson_t *poisson, int x, int y)
+{
+    const int cell_x = floorf(x / poisson->cell) + POISSON_REACH;
+    const int cell_y = floorf(y / poisson->cell) + POISSON_REACH;
+
+    return poisson->grid + cell_y * poisson->grid_width + cell_x;
+}
+
+static bool poisson_fits(poisson_t *poisson, int x, int y)
+{
+    const float radius = poisson->radius * poisson->radius;
+
+    Vector2 *cell = poisson_cell(poisson, x, y);
+    Vector2 *row;
+
+    float distance_x, distance_y;
+    bool fits = true;
+
+    // The empty cells are far away, so there's no test of them
+    for (int other_y = -POISSON_REACH; other_y <= POISSON_REACH; other_y++) {
+        row = cell + other_y * poisson->grid_width;
+
+        for (int other_x = -POISSON_REACH; other_x <= POISSON_REACH;
+                other_x++) {
+            distance_x = row[other_x].x - x;
+            distance_y = row[other_x].y - y;
+
+            fits &= distance_x * distance_x + distance_y * distance_y
+                >= radius;
+        }
+    }
+
+    return fits;
+}
+
+static void poisson_add(poisson_t *poisson, int x, int y)
+{
+    *poisson_cell(poisson, x, y) = (Vector2) { x, y };
+
+    poisson->active[poisson->active_count++] = poisson->count;
+    poisson->samples[poisson->count++] = (Vector2) { x, y };
+}
+
+static void poisson_grow(poisson_t *poisson, random_t *random)
+{
+    // The candidates are on a circle just out of the radius, from a random
+    // angle and rotated by a fixed step, as in the Roberts' variant of the
+    // algorithm. That packs the samples more than the ring between the radius
+    // and its double with less tries, and only needs a sine and a cosine for
+    // each sample.
+    const float step_cos = cosf(2 * UTILS_PI / POISSON_ATTEMPTS);
+    const float step_sin = sinf(2 * UTILS_PI / POISSON_ATTEMPTS);
+
+    // Half a cell more, as the candidates are rounded to the closest cell
+    const float distance = poisson->radius + 0.5f;
+
+    unsigned active;
+    Vector2 sample, direction;
+
+    float angle, rotated;
+    int x, y;
+
+    bool placed;
+
+    while (poisson->active_count > 0) {
+        active = random_bounded(random, poisson->active_count);
+        sample = poisson->samples[poisson->active[active]];
+
+        angle = random_float(random) * 2 * UTILS_PI;
+        direction = (Vector2) { cosf(angle), sinf(angle) };
+
+        placed = false;
+
+        for (int attempt = 0; attempt < POISSON_ATTEMPTS && !placed;
+                attempt++) {
+            x = floorf(sample.x + direction.x * distance + 0.5f);
+            y = floorf(sample.y + direction.y * distance + 0.5f);
+
+            rotated = direction.x * step_cos - direction.y * step_sin;
+            direction.y = direction.x * step_sin + direction.y * step_cos;
+            direction.x = rotated;
+
+            if (x < 0 || y < 0 || x >= poisson->width || y >= poisson->height
+                    || !poisson->mask[y * poisson->width + x]
+                    || !poisson_fits(poisson, x, y))
+                continue;
+
+            poisson_add(poisson, x, y);
+            placed = true;
+        }
+
+        if (!placed)
+            poisson->active[active] = poisson->active[--poisson->active_count];
+    }
+}
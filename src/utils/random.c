@@ -0,0 +1,205 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include "utils/random.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define RANDOM_MULTIPLIER 6364136223846793005ull
+
+// Number of generator steps that random_fill() runs at once, each lane is
+// RANDOM_LANES steps ahead of the previous one.
+#define RANDOM_LANES 8
+
+static inline uint32_t random_output(uint64_t state)
+{
+    uint32_t xorshifted = ((state >> 18) ^ state) >> 27;
+    uint32_t rotation = state >> 59;
+
+    return (xorshifted >> rotation) | (xorshifted << (-rotation & 31));
+}
+
+#if defined(__AVX2__)
+// There's no 64 bits multiplication on AVX2, it's composed of the 32 bits
+// ones, the high part of the product is discarded.
+static inline __m256i random_multiply(__m256i x, __m256i low, __m256i high)
+{
+    __m256i cross = _mm256_add_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(x, 32), low),
+        _mm256_mul_epu32(x, high));
+
+    return _mm256_add_epi64(_mm256_mul_epu32(x, low),
+        _mm256_slli_epi64(cross, 32));
+}
+
+// Outputs of the 4 states, packed on the 32 bits lanes of the result
+static inline __m128i random_output4(__m256i state)
+{
+    __m256i xorshifted = _mm256_and_si256(_mm256_srli_epi64(
+            _mm256_xor_si256(_mm256_srli_epi64(state, 18), state), 27),
+        _mm256_set1_epi64x(0xFFFFFFFF));
+
+    __m256i rotation = _mm256_srli_epi64(state, 59);
+
+    __m256i rotated = _mm256_or_si256(_mm256_srlv_epi64(xorshifted, rotation),
+        _mm256_sllv_epi64(xorshifted,
+            _mm256_sub_epi64(_mm256_set1_epi64x(32), rotation)));
+
+    return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(rotated,
+            _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7)));
+}
+#endif // __AVX2__
+
+void random_seed(random_t *random, uint64_t seed, uint64_t stream)
+{
+    random->state = 0;
+    random->increment = (stream << 1) | 1;
+
+    random_next(random);
+    random->state += seed;
+    random_next(random);
+}
+
+void random_split(random_t *random, random_t *from)
+{
+    uint64_t seed = (uint64_t) random_next(from) << 32 | random_next(from);
+    uint64_t stream = (uint64_t) random_next(from) << 32 | random_next(from);
+
+    random_seed(random, seed, stream);
+}
+
+uint32_t random_next(random_t *random)
+{
+    uint64_t state = random->state;
+
+    random->state = state * RANDOM_MULTIPLIER + random->increment;
+
+    return random_output(state);
+}
+
+uint32_t random_bounded(random_t *random, uint32_t bound)
+{
+    // Lemire's multiply and shift, the rejection only happens for the few low
+    // values that would be biased.
+    uint64_t product = (uint64_t) random_next(random) * bound;
+    uint32_t threshold;
+
+    if ((uint32_t) product < bound) {
+        threshold = -bound % bound;
+
+        while ((uint32_t) product < threshold)
+            product = (uint64_t) random_next(random) * bound;
+    }
+
+    return product >> 32;
+}
+
+int random_range(random_t *random, int min, int max)
+{ return min + (int) random_bounded(random, (uint32_t) (max - min) + 1); }
+
+float random_float(random_t *random)
+{ return (random_next(random) >> 8) * (1.0f / (1u << 24)); }
+
+double random_double(random_t *random)
+{ return random_next(random) * (1.0 / 4294967296.0); }
+
+void random_advance(random_t *random, uint64_t delta)
+{
+    uint64_t multiplier = RANDOM_MULTIPLIER;
+    uint64_t increment = random->increment;
+
+    uint64_t total_multiplier = 1;
+    uint64_t total_increment = 0;
+
+    // Brown's algorithm, composes the affine step by squaring
+    while (delta > 0) {
+        if (delta & 1) {
+            total_multiplier *= multiplier;
+            total_increment = total_increment * multiplier + increment;
+        }
+
+        increment *= multiplier + 1;
+        multiplier *= multiplier;
+        delta >>= 1;
+    }
+
+    random->state = random->state * total_multiplier + total_increment;
+}
+
+void random_fill(random_t *random, uint32_t *values, unsigned count)
+{
+    uint64_t lanes[RANDOM_LANES];
+    uint64_t state = random->state;
+
+    uint64_t multiplier = 1;
+    uint64_t increment = 0;
+
+    unsigned i = 0;
+
+    if (count >= RANDOM_LANES) {
+        // The step of RANDOM_LANES at once is still a step of the same
+        // generator, with other multiplier and increment.
+        for (int lane = 0; lane < RANDOM_LANES; lane++) {
+            lanes[lane] = state;
+            state = state * RANDOM_MULTIPLIER + random->increment;
+
+            multiplier *= RANDOM_MULTIPLIER;
+            increment = increment * RANDOM_MULTIPLIER + random->increment;
+        }
+
+#if defined(__AVX2__)
+        __m256i first = _mm256_loadu_si256((__m256i *) lanes);
+        __m256i second = _mm256_loadu_si256((__m256i *) (lanes + 4));
+
+        __m256i multiplier_low = _mm256_set1_epi64x(multiplier & 0xFFFFFFFF);
+        __m256i multiplier_high = _mm256_set1_epi64x(multiplier >> 32);
+        __m256i step = _mm256_set1_epi64x(increment);
+
+        for (; i + RANDOM_LANES <= count; i += RANDOM_LANES) {
+            _mm_storeu_si128((__m128i *) (values + i), random_output4(first));
+            _mm_storeu_si128((__m128i *) (values + i + 4),
+                random_output4(second));
+
+            first = _mm256_add_epi64(random_multiply(first, multiplier_low,
+                    multiplier_high), step);
+            second = _mm256_add_epi64(random_multiply(second, multiplier_low,
+                    multiplier_high), step);
+        }
+
+        _mm256_storeu_si256((__m256i *) lanes, first);
+#endif // __AVX2__
+
+        // The lanes don't depend on each other, so the multiplications
+        // overlap.
+        for (; i + RANDOM_LANES <= count; i += RANDOM_LANES) {
+            for (int lane = 0; lane < RANDOM_LANES; lane++) {
+                values[i + lane] = random_output(lanes[lane]);
+                lanes[lane] = lanes[lane] * multiplier + increment;
+            }
+        }
+
+        random->state = lanes[0];
+    }
+
+    for (; i < count; i++)
+        values[i] = random_next(random);
+}
@@ -0,0 +1,164 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "utils/stats.h"
+
+#define STATS_MAX_SECTIONS 32
+
+typedef struct {
+    const char *name;
+
+    double        start;
+    double        total;
+    unsigned long count;
+
+    // The samples are plain values instead of times
+    bool   sample;
+    double max;
+} stats_section_t;
+
+static struct {
+    stats_section_t sections[STATS_MAX_SECTIONS];
+    unsigned        count;
+
+    bool enabled;
+} g_stats;
+
+static stats_section_t *stats_section(const char *name);
+
+void stats_enable(bool enable)
+{ g_stats.enabled = enable; }
+
+bool stats_enabled(void)
+{ return g_stats.enabled; }
+
+void stats_begin(const char *name)
+{
+    stats_section_t *section;
+
+    if (!g_stats.enabled || (section = stats_section(name)) == NULL)
+        return;
+
+    section->start = stats_now();
+}
+
+void stats_end(const char *name)
+{
+    stats_section_t *section;
+
+    if (!g_stats.enabled || (section = stats_section(name)) == NULL)
+        return;
+
+    section->total += stats_now() - section->start;
+    section->count++;
+}
+
+void stats_sample(const char *name, double value)
+{
+    stats_section_t *section;
+
+    if (!g_stats.enabled || (section = stats_section(name)) == NULL)
+        return;
+
+    if (section->count == 0 || value > section->max)
+        section->max = value;
+
+    section->sample = true;
+    section->total += value;
+    section->count++;
+}
+
+double stats_now(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+void stats_print(FILE *file)
+{
+    stats_section_t *section;
+    bool samples = false;
+
+    fprintf(file, "%-24s %12s %10s %12s\n", "section", "total (ms)", "calls",
+        "mean (us)");
+
+    for (unsigned i = 0; i < g_stats.count; i++) {
+        section = &g_stats.sections[i];
+
+        if (section->sample) {
+            samples = true;
+            continue;
+        }
+
+        fprintf(file, "%-24s %12.3f %10lu %12.3f\n", section->name,
+            section->total * 1e3, section->count,
+            section->count > 0 ? section->total * 1e6 / section->count : 0);
+    }
+
+    if (!samples)
+        return;
+
+    fprintf(file, "\n%-24s %12s %10s %12s\n", "sample", "mean", "samples",
+        "max");
+
+    for (unsigned i = 0; i < g_stats.count; i++) {
+        section = &g_stats.sections[i];
+
+        if (section->sample)
+            fprintf(file, "%-24s %12.3f %10lu %12.3f\n", section->name,
+                section->total / section->count, section->count,
+                section->max);
+    }
+}
+
+static stats_section_t *stats_section(const char *name)
+{
+    // The names are almost always string literals, so the pointer comparison
+    // finds them without touching the characters.
+    for (unsigned i = 0; i < g_stats.count; i++)
+        if (g_stats.sections[i].name == name)
+            return &g_stats.sections[i];
+
+    for (unsigned i = 0; i < g_stats.count; i++)
+        if (strcmp(g_stats.sections[i].name, name) == 0)
+            return &g_stats.sections[i];
+
+    if (g_stats.count == STATS_MAX_SECTIONS)
+        return NULL;
+
+    g_stats.sections[g_stats.count] = (stats_section_t) {
+        .name = name,
+
+        .start = 0,
+        .total = 0,
+        .count = 0,
+
+        .sample = false,
+        .max = 0,
+    };
+
+    return &g_stats.sections[g_stats.count++];
+}
@@ -0,0 +1,223 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include "utils/timers.h"
+
+#define TIMERS_NODES_CAPACITY 32
+
+#define TIMERS_RUNNING (TIMERS_LEVELS * TIMERS_SLOTS)
+
+static void timers_insert(timers_t *timers, int node);
+static void timers_unlink(timers_t *timers, int node);
+static void timers_release(timers_t *timers, int node);
+static unsigned timers_cascade(timers_t *timers, int level, unsigned index);
+
+void timers_create(timers_t *timers)
+{
+    timers->nodes_capacity = TIMERS_NODES_CAPACITY;
+    timers->nodes = malloc(sizeof(timers_node_t) * timers->nodes_capacity);
+    timers->nodes_count = 0;
+
+    timers->unused = -1;
+
+    for (int slot = 0; slot <= TIMERS_RUNNING; slot++) {
+        timers->slots[slot].first = -1;
+        timers->slots[slot].last = -1;
+    }
+
+    timers->tick = 0;
+}
+
+void timers_destroy(timers_t *timers)
+{
+    free(timers->nodes);
+
+    timers->nodes = NULL;
+    timers->nodes_count = 0;
+    timers->nodes_capacity = 0;
+}
+
+timers_handle_t timers_start(timers_t *timers, unsigned long ticks,
+    timers_callback_t callback, void *data)
+{
+    int node;
+
+    if (timers->unused != -1) {
+        node = timers->unused;
+        timers->unused = timers->nodes[node].next;
+    } else {
+        if (timers->nodes_count == timers->nodes_capacity) {
+            timers->nodes_capacity *= 2;
+            timers->nodes = realloc(timers->nodes,
+                sizeof(timers_node_t) * timers->nodes_capacity);
+        }
+
+        node = timers->nodes_count++;
+
+        // Zero is the generation of TIMERS_NONE
+        timers->nodes[node].generation = 1;
+    }
+
+    if (ticks == 0)
+        ticks = 1;
+    else if (ticks > TIMERS_MAX_TICKS)
+        ticks = TIMERS_MAX_TICKS;
+
+    timers->nodes[node].expires = timers->tick + ticks - 1;
+    timers->nodes[node].callback = callback;
+    timers->nodes[node].data = data;
+
+    timers_insert(timers, node);
+
+    return (timers_handle_t) { node, timers->nodes[node].generation };
+}
+
+bool timers_stop(timers_t *timers, timers_handle_t handle)
+{
+    if (!timers_active(timers, handle))
+        return false;
+
+    timers_unlink(timers, handle.index);
+    timers_release(timers, handle.index);
+
+    return true;
+}
+
+bool timers_active(const timers_t *timers, timers_handle_t handle)
+{
+    return handle.index < timers->nodes_count
+        && timers->nodes[handle.index].generation == handle.generation
+        && timers->nodes[handle.index].slot != -1;
+}
+
+void timers_tick(timers_t *timers)
+{
+    const unsigned index = timers->tick & (TIMERS_SLOTS - 1);
+
+    timers_callback_t callback;
+    void *data;
+    int node;
+
+    // When the first level turns around the next slot of the second one comes
+    // down, and so on for the levels above.
+    if (index == 0) {
+        for (int level = 1; level < TIMERS_LEVELS && timers_cascade(timers,
+                    level, (timers->tick >> (TIMERS_SLOT_BITS * level))
+                        & (TIMERS_SLOTS - 1)) == 0; level++)
+            ;
+    }
+
+    // The slot is emptied before the callbacks, the timers that they start
+    // are at least on the next tick but can go to the same slot.
+    timers->slots[TIMERS_RUNNING] = timers->slots[index];
+    timers->slots[index].first = -1;
+    timers->slots[index].last = -1;
+
+    for (node = timers->slots[TIMERS_RUNNING].first; node != -1;
+            node = timers->nodes[node].next)
+        timers->nodes[node].slot = TIMERS_RUNNING;
+
+    timers->tick++;
+
+    while ((node = timers->slots[TIMERS_RUNNING].first) != -1) {
+        callback = timers->nodes[node].callback;
+        data = timers->nodes[node].data;
+
+        timers_unlink(timers, node);
+        timers_release(timers, node);
+
+        callback(data);
+    }
+}
+
+// Slot of the level that holds how far the timer expires from the next tick
+static void timers_insert(timers_t *timers, int node)
+{
+    const unsigned long expires = timers->nodes[node].expires;
+    const unsigned long distance = expires - timers->tick;
+
+    int level = 0;
+    int slot;
+
+    while (level + 1 < TIMERS_LEVELS
+            && distance >> (TIMERS_SLOT_BITS * (level + 1)) != 0)
+        level++;
+
+    slot = level * TIMERS_SLOTS
+        + ((expires >> (TIMERS_SLOT_BITS * level)) & (TIMERS_SLOTS - 1));
+
+    timers->nodes[node].slot = slot;
+    timers->nodes[node].next = -1;
+    timers->nodes[node].previous = timers->slots[slot].last;
+
+    if (timers->slots[slot].last != -1)
+        timers->nodes[timers->slots[slot].last].next = node;
+    else
+        timers->slots[slot].first = node;
+
+    timers->slots[slot].last = node;
+}
+
+static void timers_unlink(timers_t *timers, int node)
+{
+    const int slot = timers->nodes[node].slot;
+    const int previous = timers->nodes[node].previous;
+    const int next = timers->nodes[node].next;
+
+    if (previous != -1)
+        timers->nodes[previous].next = next;
+    else
+        timers->slots[slot].first = next;
+
+    if (next != -1)
+        timers->nodes[next].previous = previous;
+    else
+        timers->slots[slot].last = previous;
+}
+
+static void timers_release(timers_t *timers, int node)
+{
+    timers->nodes[node].slot = -1;
+    timers->nodes[node].generation++;
+
+    timers->nodes[node].next = timers->unused;
+    timers->unused = node;
+}
+
+// Insert again the timers of the slot, now nearer to their tick. The index is
+// returned so the caller knows when this level turned around too.
+static unsigned timers_cascade(timers_t *timers, int level, unsigned index)
+{
+    const int slot = level * TIMERS_SLOTS + index;
+
+    int node = timers->slots[slot].first;
+    int next;
+
+    timers->slots[slot].first = -1;
+    timers->slots[slot].last = -1;
+
+    for (; node != -1; node = next) {
+        next = timers->nodes[node].next;
+        timers_insert(timers, node);
+    }
+
+    return index;
+}
@@ -0,0 +1,213 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "utils/workers.h"
+
+#define WORKERS_MAX 64
+
+struct workers {
+    pthread_t *threads;
+    unsigned   count;
+
+    // Only one job can run at time, this serializes the callers that are on
+    // different threads.
+    pthread_mutex_t run_lock;
+
+    pthread_mutex_t lock;
+    pthread_cond_t  start;
+    pthread_cond_t  done;
+
+    workers_job_t job;
+    void         *context;
+    unsigned      items;
+
+    unsigned long generation;
+    unsigned      pending;
+    bool          quit;
+};
+
+typedef struct {
+    workers_t *workers;
+    unsigned   worker;
+} workers_thread_t;
+
+static void *workers_thread(void *arg);
+static void workers_run_range(workers_t *workers, unsigned worker);
+
+workers_t *workers_create(unsigned count)
+{
+    workers_t *workers = malloc(sizeof(workers_t));
+    workers_thread_t *thread;
+
+    if (count == 0)
+        count = 1;
+    else if (count > WORKERS_MAX)
+        count = WORKERS_MAX;
+
+    workers->threads = malloc(sizeof(pthread_t) * count);
+    workers->count = count;
+
+    pthread_mutex_init(&workers->run_lock, NULL);
+    pthread_mutex_init(&workers->lock, NULL);
+    pthread_cond_init(&workers->start, NULL);
+    pthread_cond_init(&workers->done, NULL);
+
+    workers->job = NULL;
+    workers->context = NULL;
+    workers->items = 0;
+
+    workers->generation = 0;
+    workers->pending = 0;
+    workers->quit = false;
+
+    // The first worker is the thread that calls workers_run()
+    for (unsigned i = 1; i < count; i++) {
+        thread = malloc(sizeof(workers_thread_t));
+        thread->workers = workers;
+        thread->worker = i;
+
+        if (pthread_create(&workers->threads[i], NULL, workers_thread,
+                    thread) != 0) {
+            free(thread);
+
+            workers->count = i;
+            break;
+        }
+    }
+
+    return workers;
+}
+
+void workers_destroy(workers_t *workers)
+{
+    if (workers == NULL)
+        return;
+
+    pthread_mutex_lock(&workers->lock);
+    workers->quit = true;
+    pthread_cond_broadcast(&workers->start);
+    pthread_mutex_unlock(&workers->lock);
+
+    for (unsigned i = 1; i < workers->count; i++)
+        pthread_join(workers->threads[i], NULL);
+
+    pthread_cond_destroy(&workers->done);
+    pthread_cond_destroy(&workers->start);
+    pthread_mutex_destroy(&workers->lock);
+    pthread_mutex_destroy(&workers->run_lock);
+
+    free(workers->threads);
+    free(workers);
+}
+
+unsigned workers_count(workers_t *workers)
+{ return workers == NULL ? 1 : workers->count; }
+
+unsigned workers_cpu_count(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (count > 0)
+        return count > WORKERS_MAX ? WORKERS_MAX : count;
+#endif // _SC_NPROCESSORS_ONLN
+
+    return 1;
+}
+
+void workers_run(workers_t *workers, unsigned items, workers_job_t job,
+    void *context)
+{
+    if (workers == NULL || workers->count == 1) {
+        job(context, 0, 0, items);
+        return;
+    }
+
+    pthread_mutex_lock(&workers->run_lock);
+
+    pthread_mutex_lock(&workers->lock);
+    workers->job = job;
+    workers->context = context;
+    workers->items = items;
+
+    workers->pending = workers->count - 1;
+    workers->generation++;
+    pthread_cond_broadcast(&workers->start);
+    pthread_mutex_unlock(&workers->lock);
+
+    workers_run_range(workers, 0);
+
+    pthread_mutex_lock(&workers->lock);
+    while (workers->pending > 0)
+        pthread_cond_wait(&workers->done, &workers->lock);
+    pthread_mutex_unlock(&workers->lock);
+
+    pthread_mutex_unlock(&workers->run_lock);
+}
+
+static void *workers_thread(void *arg)
+{
+    workers_thread_t thread = *(workers_thread_t *) arg;
+    workers_t *workers = thread.workers;
+
+    unsigned long generation = 0;
+
+    free(arg);
+
+    for (;;) {
+        pthread_mutex_lock(&workers->lock);
+        while (workers->generation == generation && !workers->quit)
+            pthread_cond_wait(&workers->start, &workers->lock);
+
+        if (workers->quit) {
+            pthread_mutex_unlock(&workers->lock);
+            break;
+        }
+
+        generation = workers->generation;
+        pthread_mutex_unlock(&workers->lock);
+
+        workers_run_range(workers, thread.worker);
+
+        pthread_mutex_lock(&workers->lock);
+        if (--workers->pending == 0)
+            pthread_cond_signal(&workers->done);
+        pthread_mutex_unlock(&workers->lock);
+    }
+
+    return NULL;
+}
+
+static void workers_run_range(workers_t *workers, unsigned worker)
+{
+    unsigned first = (unsigned long long) workers->items * worker
+        / workers->count;
+
+    unsigned last = (unsigned long long) workers->items * (worker + 1)
+        / workers->count;
+
+    if (first < last)
+        workers->job(workers->context, worker, first, last);
+}
@@ -0,0 +1,98 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <stdbool.h>
+#include "raylib.h"
+#include "game.h"
+#include "utils/utils.h"
+#include "world/entity/animation.h"
+
+static void animation_update(const animation_clip_t *clip,
+    animation_frame_t *frame);
+
+void animation_table_create(animation_table_t *table,
+    const animation_clip_info_t *clips, int count)
+{
+    animation_clip_t *clip;
+
+    table->count = min(count, ANIMATION_MAX_CLIPS);
+
+    for (int i = 0; i < table->count; i++) {
+        clip = &table->clips[i];
+
+        clip->texture = clips[i].texture != NULL ?
+            game_get_texture(clips[i].texture) : (Texture) { 0 };
+        clip->loop = clips[i].loop;
+        clip->count = min((int) (clip->texture.width / clips[i].size),
+            ANIMATION_MAX_FRAMES);
+
+        for (int frame = 0; frame < clip->count; frame++) {
+            clip->frames[frame] = (Rectangle) {
+                frame * clips[i].size, 0, clips[i].size, clips[i].size
+            };
+
+            clip->durations[frame] = max(lround(clips[i].duration
+                    * game_tick_rate()), 1);
+        }
+    }
+}
+
+void animation_play(const animation_table_t *table, animation_frame_t *frame,
+    int clip)
+{
+    frame->clip = clip;
+    frame->current = 0;
+    frame->elapsed = 0;
+
+    animation_update(&table->clips[clip], frame);
+}
+
+void animation_advance(const animation_table_t *table,
+    animation_frame_t *frame, int clip)
+{
+    const animation_clip_t *playing = &table->clips[clip];
+
+    if (clip != frame->clip) {
+        animation_play(table, frame, clip);
+        return;
+    }
+
+    if (++frame->elapsed >= playing->durations[frame->current]) {
+        frame->elapsed = 0;
+
+        if (frame->current + 1 < playing->count)
+            frame->current++;
+        else if (playing->loop)
+            frame->current = 0;
+    }
+
+    animation_update(playing, frame);
+}
+
+static void animation_update(const animation_clip_t *clip,
+    animation_frame_t *frame)
+{
+    if (frame->current >= clip->count)
+        frame->current = 0;
+
+    frame->last = clip->count > 0 && frame->current + 1 == clip->count;
+    frame->source = clip->count > 0 ? clip->frames[frame->current]
+        : (Rectangle) { 0 };
+}
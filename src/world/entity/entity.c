@@ -17,55 +17,165 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <math.h>
 #include <stdlib.h>
 #include "raylib.h"
+#include "game.h"
+#include "utils/list.h"
+#include "utils/stats.h"
+#include "utils/timers.h"
+#include "utils/utils.h"
+#include "utils/workers.h"
 #include "world/entity/entity.h"
+#include "world/entity/movement.h"
+#include "world/entity/scheduler.h"
+#include "world/map/flowfield.h"
 
-void entity_update(entity_list_t *entities, map_t *map, Rectangle camera)
+typedef struct {
+    movement_batch_t  movement;
+    entity_hit_list_t hits;
+} entity_worker_t;
+
+typedef struct {
+    entity_list_t   *entities;
+    entity_context_t context;
+} entity_job_t;
+
+static struct {
+    entity_t *snapshot;
+    unsigned  snapshot_capacity;
+
+    entity_worker_t *workers;
+    unsigned         workers_count;
+
+    flowfield_t flow;
+    scheduler_t scheduler;
+
+    // Ticked once on each entity_update(), after the hits
+    timers_t timers;
+} g_entity;
+
+static void entity_prepare(unsigned entities, unsigned workers);
+static void entity_update_range(void *job, unsigned worker, unsigned first,
+    unsigned last);
+static void entity_apply_hit(entity_list_t *entities, entity_hit_t *hit);
+static void entity_stop_timers(entity_t *entity);
+static timers_t *entity_timers(void);
+static void entity_end_cooldown(void *data);
+
+void entity_update(entity_list_t *entities, map_t *map, const hpa_t *hpa,
+    const clearance_t *clearance, Rectangle camera, workers_t *workers)
 {
-    float time = GetTime();
+    const float half = ENTITY_TILE_SIZE / TILE_DRAW_SIZE / 2;
+
     entity_t *entity;
 
+    entity_job_t job;
+
     camera.x -= (camera.width *= 2.0) / 3.0;
     camera.y -= (camera.height *= 2.0) / 3.0;
 
-    for (unsigned i = 0; i < list_size(*entities); i++) {
+    // The entities out of the camera or dead are removed before anything so
+    // the snapshot and the hits always refer to the same indexes.
+    for (unsigned i = list_size(*entities); i-- > 1;) {
         entity = list_get(*entities, i);
 
-        if (time - entity->frame.delay >= ENTITY_FRAME_DELAY) {
-            entity->frame.current++;
-
-            if (entity->frame.current >= entity->frame.max)
-                entity->frame.current = 0;
-
-            entity->frame.delay = GetTime();
-        }
-
-        if (entity->hearts <= 0 && i > 0) {
-            entity->destroy(entity);
-            list_remove(*entities, i);
-        } else if (CheckCollisionRecs(camera, (Rectangle) { entity->position.x,
-                    entity->position.y, ENTITY_TILE_SIZE / TILE_DRAW_SIZE,
+        if (entity->hearts <= 0 || !CheckCollisionRecs(camera, (Rectangle) {
+                    entity->position.x, entity->position.y,
+                    ENTITY_TILE_SIZE / TILE_DRAW_SIZE,
                     ENTITY_TILE_SIZE / TILE_DRAW_SIZE })) {
-            entity->update(i, entities, map);
-        } else if (i > 0) {
+            entity_stop_timers(entity);
             entity->destroy(entity);
             list_remove(*entities, i);
         }
     }
+
+    entity_prepare(list_size(*entities), workers_count(workers));
+
+    // Before the snapshot, so the other entities see the same choice
+    stats_begin("entities scheduler");
+    scheduler_update(&g_entity.scheduler, entities);
+    stats_end("entities scheduler");
+
+    for (unsigned i = 0; i < list_size(*entities); i++) {
+        entity = list_get(*entities, i);
+
+        entity->previous_position = entity->position;
+
+        g_entity.snapshot[i] = *entity;
+    }
+
+    // The first entity is always the player, the field follows the tile of
+    // its center.
+    stats_begin("entities flow field");
+    flowfield_update(&g_entity.flow, map,
+        g_entity.snapshot[0].position.x + half,
+        g_entity.snapshot[0].position.y + half);
+    stats_end("entities flow field");
+
+    job = (entity_job_t) {
+        .entities = entities,
+        .context = {
+            .snapshot = g_entity.snapshot,
+            .count = list_size(*entities),
+
+            .map = map,
+
+            .flow = &g_entity.flow,
+            .hpa = hpa,
+            .clearance = clearance,
+        },
+    };
+
+    stats_begin("entities simulation");
+    workers_run(workers, list_size(*entities), entity_update_range, &job);
+    stats_end("entities simulation");
+
+    stats_begin("entities hits");
+
+    // Merge the hits in the worker order, as each worker updates a contiguous
+    // range of entities it's the same order of a update in a single thread.
+    for (unsigned worker = 0; worker < g_entity.workers_count; worker++) {
+        for (unsigned i = 0; i < list_size(g_entity.workers[worker].hits); i++)
+            entity_apply_hit(entities,
+                &list_get(g_entity.workers[worker].hits, i));
+    }
+
+    stats_end("entities hits");
+
+    // After the hits, so the clips follow the state that the entities end the
+    // tick on.
+    stats_begin("entities animation");
+    for (unsigned i = 0; i < list_size(*entities); i++) {
+        entity = list_get(*entities, i);
+        animation_advance(entity->animation, &entity->frame, entity->state);
+    }
+    stats_end("entities animation");
+
+    // Last, so the timers started on this tick, before or during the update,
+    // count it as their first.
+    stats_begin("entities timers");
+    timers_tick(entity_timers());
+    stats_end("entities timers");
 }
 
-void entity_draw(entity_list_t *entities, Rectangle camera)
+void entity_draw(entity_list_t *entities, Rectangle camera, float alpha)
 {
     entity_t *entity;
+    Vector2 position;
 
     for (unsigned i = 0; i < list_size(*entities); i++) {
         entity = list_get(*entities, i);
 
-        if (CheckCollisionRecs(camera, (Rectangle) { entity->position.x,
-                    entity->position.y, ENTITY_TILE_SIZE / TILE_DRAW_SIZE,
+        position = (Vector2) {
+            lerp(entity->previous_position.x, entity->position.x, alpha),
+            lerp(entity->previous_position.y, entity->position.y, alpha),
+        };
+
+        if (CheckCollisionRecs(camera, (Rectangle) { position.x, position.y,
+                    ENTITY_TILE_SIZE / TILE_DRAW_SIZE,
                     ENTITY_TILE_SIZE / TILE_DRAW_SIZE }))
-            entity->draw(entity, camera);
+            entity->draw(entity, position, camera);
     }
 }
 
@@ -80,5 +190,185 @@ void entity_destroy(entity_list_t *entities)
 
     list_destroy(*entities);
 
+    entity_prepare(0, 0);
+
+    free(g_entity.snapshot);
+    g_entity.snapshot = NULL;
+    g_entity.snapshot_capacity = 0;
+
+    flowfield_destroy(&g_entity.flow);
+    scheduler_destroy(&g_entity.scheduler);
+    timers_destroy(&g_entity.timers);
+}
+
+uint32_t entity_checksum(entity_list_t *entities)
+{
+#define CHECKSUM_ADD(value) do {                                               \
+    const unsigned char *bytes = (const unsigned char *) &(value);             \
+                                                                               \
+    for (unsigned byte = 0; byte < sizeof(value); byte++)                      \
+        checksum = (checksum ^ bytes[byte]) * 16777619u;                       \
+} while (0)
+
+    // 32 bits FNV-1a over the fields that the update depends on
+    uint32_t checksum = 2166136261u;
+    entity_t *entity;
+
+    for (unsigned i = 0; i < list_size(*entities); i++) {
+        entity = list_get(*entities, i);
+
+        CHECKSUM_ADD(entity->position);
+        CHECKSUM_ADD(entity->direction);
+        CHECKSUM_ADD(entity->hearts);
+        CHECKSUM_ADD(entity->hitted);
+        CHECKSUM_ADD(entity->state);
+        CHECKSUM_ADD(entity->frame.current);
+        CHECKSUM_ADD(entity->ai.lag);
+        CHECKSUM_ADD(entity->ai_random.state);
+        CHECKSUM_ADD(entity->combat_random.state);
+    }
+
+    return checksum;
+
+#undef CHECKSUM_ADD
+}
+
+void entity_hit(entity_context_t *context, entity_hit_t hit)
+{
+    list_add(*context->hits, hit);
+}
+
+void entity_map_changed(void)
+{ flowfield_invalidate(&g_entity.flow); }
+
+void entity_timer_start(entity_t *entity, entity_timer_t timer, float seconds,
+    timers_callback_t callback)
+{
+    timers_t *timers = entity_timers();
+
+    timers_stop(timers, entity->timers[timer]);
+    entity->timers[timer] = timers_start(timers,
+        lround(seconds * game_tick_rate()), callback, entity);
+}
+
+static void entity_prepare(unsigned entities, unsigned workers)
+{
+    if (entities > 0 && g_entity.flow.next == NULL)
+        flowfield_create(&g_entity.flow, FLOWFIELD_RADIUS);
+
+    if (entities > 0 && g_entity.scheduler.candidates == NULL)
+        scheduler_create(&g_entity.scheduler);
+
+    if (entities > g_entity.snapshot_capacity) {
+        g_entity.snapshot_capacity = entities * 2;
+        g_entity.snapshot = realloc(g_entity.snapshot,
+            sizeof(entity_t) * g_entity.snapshot_capacity);
+    }
+
+    if (workers != g_entity.workers_count) {
+        for (unsigned i = 0; i < g_entity.workers_count; i++) {
+            movement_batch_destroy(&g_entity.workers[i].movement);
+            list_destroy(g_entity.workers[i].hits);
+        }
+
+        free(g_entity.workers);
+        g_entity.workers = workers > 0 ?
+            malloc(sizeof(entity_worker_t) * workers) : NULL;
+        g_entity.workers_count = workers;
+
+        for (unsigned i = 0; i < g_entity.workers_count; i++) {
+            movement_batch_create(&g_entity.workers[i].movement);
+            list_create(g_entity.workers[i].hits);
+        }
+    }
+
+    for (unsigned i = 0; i < g_entity.workers_count; i++)
+        list_empty(g_entity.workers[i].hits);
+}
+
+static void entity_update_range(void *job, unsigned worker, unsigned first,
+    unsigned last)
+{
+    entity_list_t *entities = ((entity_job_t *) job)->entities;
+    entity_context_t context = ((entity_job_t *) job)->context;
+    entity_worker_t *data = &g_entity.workers[worker];
+
+    entity_t *entity;
+
+    context.hits = &data->hits;
+
+    for (unsigned i = first; i < last; i++) {
+        entity = list_get(*entities, i);
+
+        entity->update(entity, i, &context);
+    }
+
+    // Each worker resolves the movement of its own entities
+    movement_batch_empty(&data->movement);
+
+    for (unsigned i = first; i < last; i++) {
+        entity = list_get(*entities, i);
+
+        movement_batch_add(&data->movement, entity->position.x,
+            entity->position.y, entity->motion.x, entity->motion.y);
+    }
+
+    movement_resolve(&data->movement, context.map,
+        ENTITY_TILE_SIZE / TILE_DRAW_SIZE);
+
+    for (unsigned i = first; i < last; i++) {
+        entity = list_get(*entities, i);
+
+        entity->position.x = data->movement.x[i - first];
+        entity->position.y = data->movement.y[i - first];
+
+        entity->motion = (Vector2) { 0, 0 };
+    }
+}
+
+static void entity_apply_hit(entity_list_t *entities, entity_hit_t *hit)
+{
+    entity_t *target = list_get(*entities, hit->target);
+
+    target->state = ENTITY_STATE_DAMAGING;
+    animation_restart(&target->frame);
+
+    target->damage_direction = hit->direction;
+
+    if (hit->turn && ((pointing_left(hit->direction)
+                && pointing_left(target->direction))
+            || (pointing_right(hit->direction)
+                && pointing_right(target->direction)))) {
+        target->direction += UTILS_PI;
+
+        if (target->direction > UTILS_PI * 2)
+            target->direction -= UTILS_PI * 2;
+    }
+
+    if (!hit->cooldown) {
+        target->hearts -= hit->damage;
+    } else if (!target->hitted) {
+        target->hearts -= hit->damage;
+        target->hitted = true;
+
+        entity_timer_start(target, ENTITY_TIMER_COOLDOWN, ENTITY_HIT_COOLDOWN,
+            entity_end_cooldown);
+    }
+}
+
+static void entity_stop_timers(entity_t *entity)
+{
+    for (int timer = 0; timer < ENTITY_TIMERS; timer++)
+        timers_stop(entity_timers(), entity->timers[timer]);
+}
+
+static timers_t *entity_timers(void)
+{
+    if (g_entity.timers.nodes == NULL)
+        timers_create(&g_entity.timers);
+
+    return &g_entity.timers;
 }
 
+static void entity_end_cooldown(void *data)
+{ ((entity_t *) data)->hitted = false; }
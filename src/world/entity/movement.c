@@ -0,0 +1,423 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "world/map/map.h"
+#include "world/map/tile.h"
+#include "utils/random.h"
+#include "utils/utils.h"
+#include "world/entity/movement.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Batches of movement_check(), each one with a count that isn't a multiple of
+// the lanes, on a map with a quarter of its tiles colliding.
+#define MOVEMENT_CHECK_BATCHES  20000
+#define MOVEMENT_CHECK_ENTITIES 37
+#define MOVEMENT_CHECK_WIDTH    60
+#define MOVEMENT_CHECK_HEIGHT   40
+
+// The cells of a box are the ones of [x, x + size - MOVEMENT_SKIN / 2], so a
+// box stopped a skin before a tile is never on it.
+#define MOVEMENT_INNER(size) ((size) - MOVEMENT_SKIN / 2)
+
+static void movement_move(movement_batch_t *batch, unsigned i, map_t *map,
+    float size, float next_x, float next_y, bool crossing);
+static float movement_before(float at, float border, float d, float size,
+    bool blocked);
+
+void movement_batch_create(movement_batch_t *batch)
+{
+    batch->count = 0;
+    batch->capacity = 0;
+
+    batch->x = batch->y = NULL;
+    batch->dx = batch->dy = NULL;
+}
+
+void movement_batch_destroy(movement_batch_t *batch)
+{
+    free(batch->x);
+    free(batch->y);
+    free(batch->dx);
+    free(batch->dy);
+
+    movement_batch_create(batch);
+}
+
+void movement_batch_add(movement_batch_t *batch, float x, float y,
+    float dx, float dy)
+{
+    if (batch->count + 1 > batch->capacity) {
+        batch->capacity = batch->capacity == 0 ? 32 : batch->capacity * 2;
+
+        batch->x = realloc(batch->x, sizeof(float) * batch->capacity);
+        batch->y = realloc(batch->y, sizeof(float) * batch->capacity);
+        batch->dx = realloc(batch->dx, sizeof(float) * batch->capacity);
+        batch->dy = realloc(batch->dy, sizeof(float) * batch->capacity);
+    }
+
+    batch->x[batch->count] = x;
+    batch->y[batch->count] = y;
+    batch->dx[batch->count] = dx;
+    batch->dy[batch->count] = dy;
+
+    batch->count++;
+}
+
+void movement_resolve(movement_batch_t *batch, map_t *map, float size)
+{
+    unsigned i = 0;
+
+#if MOVEMENT_LANES > 1
+    // The sweeps walk the tiles one by one, therefore, only the integration
+    // and the cells of the boxes before and after it run on the vector
+    // registers. The boxes that stay on the same cells can't hit anything new
+    // and skip the sweep.
+    int32_t cells[8][MOVEMENT_LANES];
+    float next[2][MOVEMENT_LANES];
+    bool crossing;
+
+    for (; i + MOVEMENT_LANES <= batch->count; i += MOVEMENT_LANES) {
+#if defined(__AVX2__)
+        __m256 x = _mm256_loadu_ps(batch->x + i);
+        __m256 y = _mm256_loadu_ps(batch->y + i);
+        __m256 next_x = _mm256_add_ps(x, _mm256_loadu_ps(batch->dx + i));
+        __m256 next_y = _mm256_add_ps(y, _mm256_loadu_ps(batch->dy + i));
+        __m256 box = _mm256_set1_ps(MOVEMENT_INNER(size));
+
+        _mm256_storeu_ps(next[0], next_x);
+        _mm256_storeu_ps(next[1], next_y);
+
+        _mm256_storeu_si256((__m256i *) cells[0], _mm256_cvttps_epi32(x));
+        _mm256_storeu_si256((__m256i *) cells[1], _mm256_cvttps_epi32(next_x));
+        _mm256_storeu_si256((__m256i *) cells[2],
+            _mm256_cvttps_epi32(_mm256_add_ps(x, box)));
+        _mm256_storeu_si256((__m256i *) cells[3],
+            _mm256_cvttps_epi32(_mm256_add_ps(next_x, box)));
+        _mm256_storeu_si256((__m256i *) cells[4], _mm256_cvttps_epi32(y));
+        _mm256_storeu_si256((__m256i *) cells[5], _mm256_cvttps_epi32(next_y));
+        _mm256_storeu_si256((__m256i *) cells[6],
+            _mm256_cvttps_epi32(_mm256_add_ps(y, box)));
+        _mm256_storeu_si256((__m256i *) cells[7],
+            _mm256_cvttps_epi32(_mm256_add_ps(next_y, box)));
+#elif defined(__SSE2__)
+        __m128 x = _mm_loadu_ps(batch->x + i);
+        __m128 y = _mm_loadu_ps(batch->y + i);
+        __m128 next_x = _mm_add_ps(x, _mm_loadu_ps(batch->dx + i));
+        __m128 next_y = _mm_add_ps(y, _mm_loadu_ps(batch->dy + i));
+        __m128 box = _mm_set1_ps(MOVEMENT_INNER(size));
+
+        _mm_storeu_ps(next[0], next_x);
+        _mm_storeu_ps(next[1], next_y);
+
+        _mm_storeu_si128((__m128i *) cells[0], _mm_cvttps_epi32(x));
+        _mm_storeu_si128((__m128i *) cells[1], _mm_cvttps_epi32(next_x));
+        _mm_storeu_si128((__m128i *) cells[2],
+            _mm_cvttps_epi32(_mm_add_ps(x, box)));
+        _mm_storeu_si128((__m128i *) cells[3],
+            _mm_cvttps_epi32(_mm_add_ps(next_x, box)));
+        _mm_storeu_si128((__m128i *) cells[4], _mm_cvttps_epi32(y));
+        _mm_storeu_si128((__m128i *) cells[5], _mm_cvttps_epi32(next_y));
+        _mm_storeu_si128((__m128i *) cells[6],
+            _mm_cvttps_epi32(_mm_add_ps(y, box)));
+        _mm_storeu_si128((__m128i *) cells[7],
+            _mm_cvttps_epi32(_mm_add_ps(next_y, box)));
+#elif defined(__ARM_NEON)
+        float32x4_t x = vld1q_f32(batch->x + i);
+        float32x4_t y = vld1q_f32(batch->y + i);
+        float32x4_t next_x = vaddq_f32(x, vld1q_f32(batch->dx + i));
+        float32x4_t next_y = vaddq_f32(y, vld1q_f32(batch->dy + i));
+        float32x4_t box = vdupq_n_f32(MOVEMENT_INNER(size));
+
+        vst1q_f32(next[0], next_x);
+        vst1q_f32(next[1], next_y);
+
+        vst1q_s32(cells[0], vcvtq_s32_f32(x));
+        vst1q_s32(cells[1], vcvtq_s32_f32(next_x));
+        vst1q_s32(cells[2], vcvtq_s32_f32(vaddq_f32(x, box)));
+        vst1q_s32(cells[3], vcvtq_s32_f32(vaddq_f32(next_x, box)));
+        vst1q_s32(cells[4], vcvtq_s32_f32(y));
+        vst1q_s32(cells[5], vcvtq_s32_f32(next_y));
+        vst1q_s32(cells[6], vcvtq_s32_f32(vaddq_f32(y, box)));
+        vst1q_s32(cells[7], vcvtq_s32_f32(vaddq_f32(next_y, box)));
+#endif
+
+        for (int lane = 0; lane < MOVEMENT_LANES; lane++) {
+            crossing = cells[0][lane] != cells[1][lane]
+                || cells[2][lane] != cells[3][lane]
+                || cells[4][lane] != cells[5][lane]
+                || cells[6][lane] != cells[7][lane];
+
+            movement_move(batch, i + lane, map, size, next[0][lane],
+                next[1][lane], crossing);
+        }
+    }
+#endif // MOVEMENT_LANES > 1
+
+    movement_resolve_scalar(batch, i, map, size);
+}
+
+void movement_resolve_scalar(movement_batch_t *batch, unsigned first,
+    map_t *map, float size)
+{
+    float x, y;
+    float next_x, next_y;
+    bool crossing;
+
+    for (unsigned i = first; i < batch->count; i++) {
+        x = batch->x[i];
+        y = batch->y[i];
+
+        next_x = x + batch->dx[i];
+        next_y = y + batch->dy[i];
+
+        // The same truncations of the lanes
+        crossing = (int32_t) x != (int32_t) next_x
+            || (int32_t) (x + MOVEMENT_INNER(size))
+                != (int32_t) (next_x + MOVEMENT_INNER(size))
+            || (int32_t) y != (int32_t) next_y
+            || (int32_t) (y + MOVEMENT_INNER(size))
+                != (int32_t) (next_y + MOVEMENT_INNER(size));
+
+        movement_move(batch, i, map, size, next_x, next_y, crossing);
+    }
+}
+
+bool movement_sweep(map_t *map, float x, float y, float size, float dx,
+    float dy, movement_hit_t *hit)
+{
+    const float inner = MOVEMENT_INNER(size);
+
+    // Side of the box that leads on each axis, the next border it crosses and
+    // the fraction of the displacement walked until it does.
+    const float lead_x = dx > 0 ? x + inner : x;
+    const float lead_y = dy > 0 ? y + inner : y;
+
+    float border_x = dx > 0 ? floorf(lead_x) + 1 : floorf(lead_x);
+    float border_y = dy > 0 ? floorf(lead_y) + 1 : floorf(lead_y);
+    float time_x = dx != 0 ? (border_x - lead_x) / dx : INFINITY;
+    float time_y = dy != 0 ? (border_y - lead_y) / dy : INFINITY;
+
+    float time, at_x, at_y;
+    bool entering_x, entering_y;
+    bool blocked_x, blocked_y;
+    int first, last;
+
+    while ((time = min(time_x, time_y)) <= 1) {
+        at_x = x + dx * time;
+        at_y = y + dy * time;
+
+        // Both borders are crossed at once when the box goes through a
+        // corner, the tile on the corner is checked with the column.
+        entering_x = time_x == time;
+        entering_y = time_y == time;
+
+        blocked_x = false;
+        blocked_y = false;
+
+        if (entering_x) {
+            first = floorf(at_y);
+            last = floorf(at_y + inner);
+
+            if (entering_y && dy > 0)
+                last++;
+            else if (entering_y)
+                first--;
+
+            for (int row = first; row <= last && !blocked_x; row++) {
+                blocked_x = map_collides(map,
+                    dx > 0 ? border_x : border_x - 1, row);
+            }
+        }
+
+        if (entering_y) {
+            first = floorf(at_x);
+            last = floorf(at_x + inner);
+
+            for (int column = first; column <= last && !blocked_y; column++) {
+                blocked_y = map_collides(map, column,
+                    dy > 0 ? border_y : border_y - 1);
+            }
+        }
+
+        if (blocked_x || blocked_y) {
+            *hit = (movement_hit_t) { time, at_x, at_y, blocked_x, blocked_y };
+
+            hit->x = movement_before(at_x, border_x, dx, size, blocked_x);
+            hit->y = movement_before(at_y, border_y, dy, size, blocked_y);
+
+            return true;
+        }
+
+        if (entering_x) {
+            border_x += dx > 0 ? 1 : -1;
+            time_x = (border_x - lead_x) / dx;
+        }
+
+        if (entering_y) {
+            border_y += dy > 0 ? 1 : -1;
+            time_y = (border_y - lead_y) / dy;
+        }
+    }
+
+    *hit = (movement_hit_t) {
+        1,
+        movement_before(x + dx, border_x, dx, size, false),
+        movement_before(y + dy, border_y, dy, size, false),
+        false,
+        false
+    };
+
+    return false;
+}
+
+// Resolve seeded random batches through the vector and the scalar paths and
+// count the positions that differ.
+bool movement_check(FILE *file)
+{
+    const float size = 0.5f;
+
+    movement_batch_t simd, scalar;
+    map_t map;
+
+    random_t random;
+    float x, y, dx, dy, angle, speed;
+    unsigned long count = 0, differences = 0;
+
+    random_seed(&random, 1, RANDOM_STREAM_AI);
+
+    map_create(&map, MOVEMENT_CHECK_WIDTH, MOVEMENT_CHECK_HEIGHT);
+
+    for (int row = 0; row < map.height; row++)
+        for (int column = 0; column < map.width; column++)
+            if (random_bounded(&random, 4) == 0)
+                map.tiles[random_bounded(&random, MAP_MAX_LAYERS)][row][column]
+                    = tile_collidable(tile_new(1, 1));
+
+    movement_batch_create(&simd);
+    movement_batch_create(&scalar);
+
+    for (int batch = 0; batch < MOVEMENT_CHECK_BATCHES; batch++) {
+        movement_batch_empty(&simd);
+        movement_batch_empty(&scalar);
+
+        // Mostly the steps of a tick, and some long ones that cross tiles
+        for (int i = 0; i < MOVEMENT_CHECK_ENTITIES; i++) {
+            x = random_float(&random) * (map.width - size);
+            y = random_float(&random) * (map.height - size);
+
+            angle = random_float(&random) * (float) (UTILS_PI * 2);
+            speed = random_float(&random) * (random_bounded(&random, 4) == 0 ?
+                5.0f : 0.2f);
+
+            dx = cosf(angle) * speed;
+            dy = sinf(angle) * speed;
+
+            movement_batch_add(&simd, x, y, dx, dy);
+            movement_batch_add(&scalar, x, y, dx, dy);
+        }
+
+        movement_resolve(&simd, &map, size);
+        movement_resolve_scalar(&scalar, 0, &map, size);
+
+        for (unsigned i = 0; i < simd.count; i++, count++)
+            if (memcmp(&simd.x[i], &scalar.x[i], sizeof(float)) != 0
+                    || memcmp(&simd.y[i], &scalar.y[i], sizeof(float)) != 0)
+                differences++;
+    }
+
+    fprintf(file, "movement: %lu entities on %d lanes, %lu differences\n",
+        count, MOVEMENT_LANES, differences);
+
+    movement_batch_destroy(&simd);
+    movement_batch_destroy(&scalar);
+    map_destroy(&map);
+
+    return differences == 0;
+}
+
+// Move the box to the next position, or sweep it when it crosses to other
+// cells: it stops a skin before the tiles hit and slides along them with the
+// rest of the displacement.
+static void movement_move(movement_batch_t *batch, unsigned i, map_t *map,
+    float size, float next_x, float next_y, bool crossing)
+{
+    float dx = batch->dx[i];
+    float dy = batch->dy[i];
+
+    movement_hit_t hit;
+    bool stopped;
+
+    if (crossing) {
+        next_x = batch->x[i];
+        next_y = batch->y[i];
+
+        // Each hit stops an axis, so there are at most two
+        for (int pass = 0; pass < 3 && (dx != 0 || dy != 0); pass++) {
+            stopped = movement_sweep(map, next_x, next_y, size, dx, dy, &hit);
+
+            next_x = hit.x;
+            next_y = hit.y;
+
+            if (!stopped)
+                break;
+
+            dx = hit.blocked_x ? 0 : dx * (1 - hit.time);
+            dy = hit.blocked_y ? 0 : dy * (1 - hit.time);
+        }
+    }
+
+    // Keep the entities inside the map, the comparisons keep -0 as it is
+    if (next_x < 0)
+        next_x = 0;
+    else if (next_x > map->width - size)
+        next_x = map->width - size;
+
+    if (next_y < 0)
+        next_y = 0;
+    else if (next_y > map->height - size)
+        next_y = map->height - size;
+
+    batch->x[i] = next_x;
+    batch->y[i] = next_y;
+}
+
+// Position on the axis a skin before the border when it stopped the box, or
+// when the rounding of the position crossed it before the sweep did.
+static float movement_before(float at, float border, float d, float size,
+    bool blocked)
+{
+    if (d > 0 && (blocked || floorf(at + MOVEMENT_INNER(size)) >= border))
+        return border - size - MOVEMENT_SKIN;
+    else if (d < 0 && (blocked || floorf(at) < border))
+        return border + MOVEMENT_SKIN;
+
+    return at;
+}
+
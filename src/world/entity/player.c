@@ -24,6 +24,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdio.h>
 #include <string.h>
 #include "game.h"
+#include "utils/fastmath.h"
 #include "utils/list.h"
 #include "utils/utils.h"
 #include "world/map/tile.h"
@@ -31,40 +32,74 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "world/entity/entity.h"
 #include "world/entity/player.h"
 
-#define PLAYER_DEFAULT_VELOCITY 5
-
-static void update(unsigned entity, entity_list_t *entities, map_t *map);
-static void draw(entity_t *player, Rectangle camera);
+static void update(entity_t *base, unsigned index, entity_context_t *context);
+static void draw(entity_t *player, Vector2 position, Rectangle camera);
 static void destroy(entity_t *player);
+static void end_attack(void *data);
 
 static FILE *player_goto_section(void);
+static const animation_table_t *player_animation(void);
+
+// Clips of the player, on the order of the states
+static const animation_clip_info_t player_clips[] = {
+    [ENTITY_STATE_SPAWN] = { NULL, ENTITY_SPRITE_SIZE, ENTITY_FRAME_DELAY,
+        false },
+    [ENTITY_STATE_MOVING] = { "player-moving", ENTITY_SPRITE_SIZE,
+        ENTITY_FRAME_DELAY, true },
+    [ENTITY_STATE_IDLE] = { "player-idle", ENTITY_SPRITE_SIZE,
+        ENTITY_FRAME_DELAY, true },
+    [ENTITY_STATE_DAMAGING] = { "player-damaging", ENTITY_SPRITE_SIZE,
+        ENTITY_FRAME_DELAY, false },
+};
+
+static struct {
+    animation_table_t animation;
+} g_player;
 
 player_t *player_create(Vector2 position)
 {
     player_t *player = malloc(sizeof(player_t));
 
     player->base.position = position;
+    player->base.previous_position = position;
     player->base.velocity = PLAYER_DEFAULT_VELOCITY;
+    player->base.motion = (Vector2) { 0, 0 };
+    player->base.direction = 0;
+    player->base.damage_direction = 0;
+    player->base.spawner_id = 0;
 
-    player->base.attack = 20;
-    player->base.defense = 20;
+    player->base.attack = PLAYER_DEFAULT_ATTACK;
+    player->base.defense = PLAYER_DEFAULT_DEFENSE;
 
     player->base.draw = draw;
     player->base.update = update;
     player->base.destroy = destroy;
 
-    player->base.hearts = 100;
-    player->base.max_hearts = 100;
+    player->base.hearts = PLAYER_DEFAULT_HEARTS;
+    player->base.max_hearts = PLAYER_DEFAULT_HEARTS;
+    player->base.hitted = false;
+
+    random_split(&player->base.ai_random, game_random(RANDOM_STREAM_AI));
+    random_split(&player->base.combat_random,
+        game_random(RANDOM_STREAM_COMBAT));
 
     player->base.state = ENTITY_STATE_IDLE;
 
+    player->base.animation = player_animation();
+    animation_play(player->base.animation, &player->base.frame,
+        player->base.state);
+
+    for (int timer = 0; timer < ENTITY_TIMERS; timer++)
+        player->base.timers[timer] = TIMERS_NONE;
+
+    player->base.ai.think = 1;
+    player->base.ai.engaged = false;
+    player->base.ai.lag = 0;
+
     player->attacked = false;
-    player->attacking = 0;
+    player->attacking = false;
 
-    player->spritesheet.moving = game_get_texture("player-moving");
-    player->spritesheet.damaging = game_get_texture("player-damaging");
-    player->spritesheet.idle = game_get_texture("player-idle");
-    player->spritesheet.sword = game_get_texture("player-sword");
+    player->sword = game_get_texture("player-sword");
 
     return player;
 }
@@ -208,10 +243,17 @@ bool player_exists(void)
     return player_section_found && !open_player_section;
 }
 
-static void update(unsigned entity, entity_list_t *entities, map_t *map)
+void player_attack(player_t *player)
 {
-    entity_t *base = list_get(*entities, entity);
-    entity_t *enemy;
+    player->attacking = true;
+
+    entity_timer_start(&player->base, ENTITY_TIMER_ACTION, PLAYER_ATTACK_TIME,
+        end_attack);
+}
+
+static void update(entity_t *base, unsigned index, entity_context_t *context)
+{
+    const entity_t *enemy;
     player_t *player = (player_t *) base;
 
     Rectangle player_rect;
@@ -219,181 +261,132 @@ static void update(unsigned entity, entity_list_t *entities, map_t *map)
 
     Vector2 next_position = base->position;
 
-    Vector2 bounds[4] = {
-        { 0, 0 },
-        { ENTITY_TILE_SIZE / TILE_DRAW_SIZE, 0 },
-        { 0, ENTITY_TILE_SIZE / TILE_DRAW_SIZE },
-        { ENTITY_TILE_SIZE / TILE_DRAW_SIZE, ENTITY_TILE_SIZE / TILE_DRAW_SIZE },
+    Vector2 size = {
+        ENTITY_TILE_SIZE / TILE_DRAW_SIZE, ENTITY_TILE_SIZE / TILE_DRAW_SIZE
     };
 
-    static float hitted = 0;
+    // The direction doesn't change on the update, the walk and the attack
+    // against each enemy share it.
+    const Vector2 heading = fastmath_unit(base->direction);
+    Vector2 recoil;
 
     if (player->attacked)
-        player->attacking = 0;
-
-    if (player->attacking > 0 && GetTime() - player->attacking >= 0.05) {
-        player->attacked = true;
-        player->attacking = 0;
-    }
+        player->attacking = false;
 
     switch (base->state) {
     case ENTITY_STATE_SPAWN:
         break;
 
     case ENTITY_STATE_MOVING:
-        base->frame.max = player->spritesheet.moving.width / ENTITY_SPRITE_SIZE;
-
-        next_position.x += cos(base->direction) * base->velocity
-            * GetFrameTime();
-
-        next_position.y += sin(base->direction) * base->velocity
-            * GetFrameTime();
-
-        for (int i = 0; i < 4; i++) {
-            for (int layer = 0; layer < MAP_MAX_LAYERS; layer++) {
-                if (tile_collision(map_tile(map, layer,
-                                next_position.x + bounds[i].x,
-                                base->position.y + bounds[i].y)))
-                    next_position.x = base->position.x;
-
-                if (tile_collision(map_tile(map, layer,
-                                base->position.x + bounds[i].x,
-                                next_position.y + bounds[i].y)))
-                    next_position.y = base->position.y;
-            }
-        }
+        base->motion.x = heading.x * base->velocity * game_tick_delta();
+        base->motion.y = heading.y * base->velocity * game_tick_delta();
 
         break;
 
     case ENTITY_STATE_DAMAGING:
-        base->frame.max = player->spritesheet.damaging.width / ENTITY_SPRITE_SIZE;
-
-        next_position.x += cos(base->damage_direction) * (base->velocity / 2)
-            * GetFrameTime();
-
-        next_position.y += sin(base->damage_direction) * (base->velocity / 2)
-            * GetFrameTime();
+        recoil = fastmath_unit(base->damage_direction);
 
-        for (int i = 0; i < 4; i++) {
-            for (int layer = 0; layer < MAP_MAX_LAYERS; layer++) {
-                if (tile_collision(map_tile(map, layer,
-                                next_position.x + bounds[i].x,
-                                base->position.y + bounds[i].y)))
-                    next_position.x = base->position.x;
-
-                if (tile_collision(map_tile(map, layer,
-                                base->position.x + bounds[i].x,
-                                next_position.y + bounds[i].y)))
-                    next_position.y = base->position.y;
-            }
-        }
+        base->motion.x = recoil.x * (base->velocity / 2) * game_tick_delta();
+        base->motion.y = recoil.y * (base->velocity / 2) * game_tick_delta();
 
-        if (base->frame.current + 1 == base->frame.max) {
+        if (base->frame.last)
             base->state = ENTITY_STATE_IDLE;
-            base->frame.current = 0;
-        }
 
         break;
 
     case ENTITY_STATE_IDLE:
-        base->frame.max = player->spritesheet.idle.width / ENTITY_SPRITE_SIZE;
         break;
     }
 
-    for (unsigned i = 1; i < list_size(*entities); i++) {
-        enemy = list_get(*entities, i);
+    // The collision against the map is only resolved later, so the enemies
+    // are tested against the position the player wants to reach.
+    next_position.x += base->motion.x;
+    next_position.y += base->motion.y;
+
+    for (unsigned i = 0; i < context->count; i++) {
+        if (i == index)
+            continue;
+
+        enemy = &context->snapshot[i];
 
         player_rect = (Rectangle) {
             .x = next_position.x,
             .y = next_position.y,
 
-            .width = bounds[3].x,
-            .height = bounds[3].y,
+            .width = size.x,
+            .height = size.y,
         };
 
         enemy_rect = (Rectangle) {
             .x = enemy->position.x,
             .y = enemy->position.y,
 
-            .width = bounds[3].x,
-            .height = bounds[3].y,
+            .width = size.x,
+            .height = size.y,
         };
 
         if (base->state == ENTITY_STATE_MOVING
                 && CheckCollisionRecs(player_rect, enemy_rect)) {
             base->state = ENTITY_STATE_DAMAGING;
-            base->frame.current = 0;
+            animation_restart(&base->frame);
 
             base->damage_direction = base->direction + UTILS_PI;
             if (base->damage_direction > UTILS_PI * 2)
                 base->damage_direction -= UTILS_PI * 2;
 
-            if (hitted == 0) {
-                base->hearts -= max((enemy->attack - base->defense)
-                    * (rand() % 2), 5);
+            // The hearts and the cooldown go through a hit, the cooldown is
+            // only started outside of the updates.
+            if (!base->hitted) {
+                entity_hit(context, (entity_hit_t) {
+                    .source = i,
+                    .target = index,
+
+                    .damage = max((enemy->attack - base->defense)
+                        * random_bounded(&base->combat_random, 2), 5),
+                    .direction = base->damage_direction,
 
-                hitted = GetTime();
+                    .cooldown = true,
+                    .turn = false,
+                });
             }
 
             next_position = base->position;
+            base->motion = (Vector2) { 0, 0 };
         }
 
-        player_rect.x += cos(base->direction) * player_rect.width;
-        player_rect.y += sin(base->direction) * player_rect.height;
+        player_rect.x += heading.x * player_rect.width;
+        player_rect.y += heading.y * player_rect.height;
 
-        if (player->attacking > 0 && CheckCollisionRecs(player_rect,
+        if (player->attacking && CheckCollisionRecs(player_rect,
                     enemy_rect)) {
-            enemy->state = ENTITY_STATE_DAMAGING;
-            enemy->frame.current = 0;
+            entity_hit(context, (entity_hit_t) {
+                .source = index,
+                .target = i,
 
-            enemy->hearts -= max((base->attack - enemy->defense)
-                * (rand() % 2), 5);
+                .damage = max((base->attack - enemy->defense)
+                    * random_bounded(&base->combat_random, 2), 5),
+                .direction = base->direction,
 
-            enemy->damage_direction = base->direction;
-
-            if ((pointing_left(base->direction)
-                    && pointing_left(enemy->direction))
-                    || (pointing_right(base->direction)
-                        && pointing_right(enemy->direction))) {
-                enemy->direction += UTILS_PI;
-
-                if (enemy->direction > UTILS_PI * 2)
-                    enemy->direction -= UTILS_PI * 2;
-            }
+                .cooldown = false,
+                .turn = true,
+            });
 
             player->attacked = true;
         }
     }
-
-    if (hitted > 0 && GetTime() - hitted >= 0.3)
-        hitted = 0;
-
-    if (next_position.x < 0)
-        next_position.x = 0;
-
-    if (next_position.y < 0)
-        next_position.y = 0;
-
-    base->position = next_position;
 }
 
-static void draw(entity_t *base, Rectangle camera)
+static void draw(entity_t *base, Vector2 position, Rectangle camera)
 {
     player_t *player = (player_t *) base;
 
-    Texture spritesheet;
+    Vector2 heading;
 
-    Rectangle sprite = {
-        .x = base->frame.current * ENTITY_SPRITE_SIZE,
-        .y = 0,
-
-        .width = ENTITY_SPRITE_SIZE,
-        .height = ENTITY_SPRITE_SIZE,
-    };
+    Rectangle sprite = base->frame.source;
 
     Rectangle tile = {
-        .x = (base->position.x - camera.x) * TILE_DRAW_SIZE,
-        .y = (base->position.y - camera.y) * TILE_DRAW_SIZE,
+        .x = (position.x - camera.x) * TILE_DRAW_SIZE,
+        .y = (position.y - camera.y) * TILE_DRAW_SIZE,
 
         .width = ENTITY_TILE_SIZE,
         .height = ENTITY_TILE_SIZE,
@@ -406,23 +399,6 @@ static void draw(entity_t *base, Rectangle camera)
         .height = ENTITY_HEART_BAR_HEIGHT,
     };
 
-    switch (base->state) {
-    case ENTITY_STATE_SPAWN:
-        break;
-
-    case ENTITY_STATE_MOVING:
-        spritesheet = player->spritesheet.moving;
-        break;
-
-    case ENTITY_STATE_DAMAGING:
-        spritesheet = player->spritesheet.damaging;
-        break;
-
-    case ENTITY_STATE_IDLE:
-        spritesheet = player->spritesheet.idle;
-        break;
-    }
-
     if (base->hearts < base->max_hearts) {
         heart_bar_rect.width = (base->hearts / base->max_hearts)
             * ENTITY_HEART_BAR_WIDTH;
@@ -436,7 +412,8 @@ static void draw(entity_t *base, Rectangle camera)
     if (base->direction > deg2rad(90) && base->direction < deg2rad(270))
         sprite.width = -sprite.width;
 
-    DrawTexturePro(spritesheet, sprite, tile, (Vector2) { 0, 0 }, 0, WHITE);
+    DrawTexturePro(animation_texture(base->animation, &base->frame), sprite,
+        tile, (Vector2) { 0, 0 }, 0, WHITE);
 
     if (player->attacking) {
         // Disable the horizontal flip of the sword
@@ -446,10 +423,12 @@ static void draw(entity_t *base, Rectangle camera)
         if (base->direction > deg2rad(90) && base->direction < deg2rad(270))
             sprite.height = -sprite.height;
 
-        tile.x += tile.width / 2 + cos(base->direction) * tile.width;
-        tile.y += tile.height / 2 + sin(base->direction) * tile.height;
+        heading = fastmath_unit(base->direction);
+
+        tile.x += tile.width / 2 + heading.x * tile.width;
+        tile.y += tile.height / 2 + heading.y * tile.height;
 
-        DrawTexturePro(player->spritesheet.sword, sprite, tile,
+        DrawTexturePro(player->sword, sprite, tile,
             (Vector2) { tile.width / 2, tile.height / 2 },
             rad2deg(base->direction), WHITE);
     }
@@ -460,6 +439,14 @@ static void destroy(entity_t *player)
     free((player_t *) player);
 }
 
+static void end_attack(void *data)
+{
+    player_t *player = data;
+
+    player->attacked = true;
+    player->attacking = false;
+}
+
 static FILE *player_goto_section(void)
 {
     int c;
@@ -491,3 +478,11 @@ static FILE *player_goto_section(void)
     return (file = game_file("a"));
 }
 
+static const animation_table_t *player_animation(void)
+{
+    if (g_player.animation.count == 0)
+        animation_table_create(&g_player.animation, player_clips,
+            sizeof(player_clips) / sizeof(player_clips[0]));
+
+    return &g_player.animation;
+}
@@ -0,0 +1,124 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include "utils/list.h"
+#include "utils/stats.h"
+#include "utils/utils.h"
+#include "world/entity/entity.h"
+#include "world/entity/scheduler.h"
+
+static int scheduler_compare(const void *a, const void *b);
+
+void scheduler_create(scheduler_t *scheduler)
+{
+    scheduler->capacity = 32;
+    scheduler->candidates = malloc(sizeof(scheduler_candidate_t)
+        * scheduler->capacity);
+}
+
+void scheduler_destroy(scheduler_t *scheduler)
+{
+    free(scheduler->candidates);
+
+    scheduler->candidates = NULL;
+    scheduler->capacity = 0;
+}
+
+void scheduler_update(scheduler_t *scheduler, entity_list_t *entities)
+{
+    const entity_t *player = list_get(*entities, 0);
+
+    entity_t *entity;
+    unsigned count = 0;
+    unsigned chosen;
+    unsigned lag = 0;
+    float distance;
+    unsigned period;
+
+    if (list_size(*entities) > scheduler->capacity) {
+        while (scheduler->capacity < list_size(*entities))
+            scheduler->capacity *= 2;
+
+        scheduler->candidates = realloc(scheduler->candidates,
+            sizeof(scheduler_candidate_t) * scheduler->capacity);
+    }
+
+    list_get(*entities, 0)->ai.think = 1;
+
+    for (unsigned i = 1; i < list_size(*entities); i++) {
+        entity = list_get(*entities, i);
+        entity->ai.think = 0;
+
+        distance = hypotf(entity->position.x - player->position.x,
+            entity->position.y - player->position.y);
+
+        period = entity->ai.engaged ? 1 : min((unsigned) (distance
+                / SCHEDULER_NEAR_RADIUS) + 1, SCHEDULER_MAX_PERIOD);
+
+        if (entity->ai.lag + 1 >= period)
+            scheduler->candidates[count++] = (scheduler_candidate_t) {
+                .index = i,
+                .lag = entity->ai.lag + 1,
+                .period = period,
+            };
+    }
+
+    qsort(scheduler->candidates, count, sizeof(scheduler_candidate_t),
+        scheduler_compare);
+
+    chosen = min(count, SCHEDULER_BUDGET);
+
+    for (unsigned i = 0; i < chosen; i++) {
+        entity = list_get(*entities, scheduler->candidates[i].index);
+        entity->ai.think = entity->ai.lag + 1;
+    }
+
+    for (unsigned i = 1; i < list_size(*entities); i++) {
+        entity = list_get(*entities, i);
+
+        if (entity->ai.think)
+            entity->ai.lag = 0;
+        else
+            lag = max(lag, ++entity->ai.lag);
+    }
+
+    stats_sample("ai decisions", chosen);
+    stats_sample("ai deferred", count - chosen);
+    stats_sample("ai lag (ticks)", lag);
+}
+
+static int scheduler_compare(const void *a, const void *b)
+{
+    const scheduler_candidate_t *first = a;
+    const scheduler_candidate_t *second = b;
+
+    // Periods behind, compared without dividing
+    unsigned long behind = (unsigned long) first->lag * second->period;
+    unsigned long other = (unsigned long) second->lag * first->period;
+
+    if (behind != other)
+        return behind < other ? 1 : -1;
+
+    if (first->period != second->period)
+        return first->period < second->period ? -1 : 1;
+
+    return (first->index > second->index) - (first->index < second->index);
+}
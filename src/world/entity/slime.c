@@ -22,13 +22,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdlib.h>
 #include "raylib.h"
 #include "game.h"
+#include "utils/fastmath.h"
 #include "utils/list.h"
 #include "utils/utils.h"
+#include "world/map/clearance.h"
+#include "world/map/flowfield.h"
+#include "world/map/hpa.h"
+#include "world/map/raycast.h"
 #include "world/map/tile.h"
 #include "world/map/map.h"
 #include "world/entity/entity.h"
 
 #define SLIME_PLAYER_UNTARGET_RADIUS 12
+
+// Tiles ahead of its center that a wandering slime looks for obstacles
+#define SLIME_WANDER_AHEAD 0.75
 #define SQ(x) ((x) * (x))
 
 typedef struct {
@@ -38,19 +46,44 @@ typedef struct {
         float field;
         float radius;
         bool target_player;
+
+        // Cosine of half the field, the points with a lower cosine to the
+        // direction of the slime are out of it.
+        float cosine;
     } view;
 
-    struct {
-        Texture spawn;
-        Texture moving;
-        Texture damaging;
-        Texture idle;
-    } spritesheet;
+    // Walk to the player when it's around obstacles bigger than the field
+    hpa_path_t path;
+
+    // Set once the direction of the current move is chosen
+    bool headed;
 } slime_t;
 
-static void update(unsigned entity, entity_list_t *entities, map_t *map);
-static void draw(entity_t *entity, Rectangle camera);
+static void update(entity_t *base, unsigned index, entity_context_t *context);
+static float chase(entity_t *base, const entity_t *player,
+    entity_context_t *context);
+static bool walk(slime_t *slime, int x, int y, int goal_x, int goal_y,
+    const hpa_t *hpa, int *next_x, int *next_y);
+static float wander(entity_t *base, entity_context_t *context);
+static void draw(entity_t *entity, Vector2 position, Rectangle camera);
 static void destroy(entity_t *entity);
+static const animation_table_t *slime_animation(void);
+
+// Clips of the slimes, on the order of the states
+static const animation_clip_info_t slime_clips[] = {
+    [ENTITY_STATE_SPAWN] = { "slime-spawn", ENTITY_SPRITE_SIZE,
+        ENTITY_FRAME_DELAY, false },
+    [ENTITY_STATE_MOVING] = { "slime-moving", ENTITY_SPRITE_SIZE,
+        ENTITY_FRAME_DELAY, false },
+    [ENTITY_STATE_IDLE] = { "slime-idle", ENTITY_SPRITE_SIZE,
+        ENTITY_FRAME_DELAY, true },
+    [ENTITY_STATE_DAMAGING] = { "slime-damaging", ENTITY_SPRITE_SIZE,
+        ENTITY_FRAME_DELAY, false },
+};
+
+static struct {
+    animation_table_t animation;
+} g_slime;
 
 entity_t *slime_create(Vector2 position)
 {
@@ -61,39 +94,54 @@ entity_t *slime_create(Vector2 position)
     slime->base.destroy = destroy;
 
     slime->base.position = position;
+    slime->base.previous_position = position;
+    slime->base.motion = (Vector2) { 0, 0 };
     slime->base.velocity = 4;
-    slime->base.direction = deg2rad(rand() % 360);
+    slime->base.direction = deg2rad(random_bounded(
+            game_random(RANDOM_STREAM_AI), 360));
 
     slime->base.hearts = 30;
     slime->base.max_hearts = 30;
+    slime->base.hitted = false;
+
+    random_split(&slime->base.ai_random, game_random(RANDOM_STREAM_AI));
+    random_split(&slime->base.combat_random,
+        game_random(RANDOM_STREAM_COMBAT));
 
     slime->base.attack = 10;
     slime->base.defense = 5;
 
-    slime->base.frame.current = 0;
-    slime->base.frame.delay = GetTime();
-    slime->base.frame.max = 0;
+    for (int timer = 0; timer < ENTITY_TIMERS; timer++)
+        slime->base.timers[timer] = TIMERS_NONE;
+
+    slime->base.ai.think = 1;
+    slime->base.ai.engaged = false;
+    slime->base.ai.lag = 0;
 
     slime->base.state = ENTITY_STATE_SPAWN;
 
+    slime->base.animation = slime_animation();
+    animation_play(slime->base.animation, &slime->base.frame,
+        slime->base.state);
+
     slime->view.field = deg2rad(60);
     slime->view.radius = 4;
     slime->view.target_player = false;
+    slime->view.cosine = cos(slime->view.field / 2.0);
 
-    slime->spritesheet.spawn = game_get_texture("slime-spawn");
-    slime->spritesheet.moving = game_get_texture("slime-moving");
-    slime->spritesheet.idle = game_get_texture("slime-idle");
-    slime->spritesheet.damaging = game_get_texture("slime-damaging");
+    slime->headed = false;
+
+    hpa_path_create(&slime->path);
 
     return (entity_t *) slime;
 }
 
-static void update(unsigned entity, entity_list_t *entities, map_t *map)
+static void update(entity_t *base, unsigned index, entity_context_t *context)
 {
-    entity_t *base = list_get(*entities, entity);
     slime_t *slime = (slime_t *) base;
 
-    entity_t *player = list_get(*entities, 0);
+    // The first entity its always the player
+    const entity_t *player = &context->snapshot[0];
 
     Vector2 next_position = base->position;
 
@@ -104,60 +152,48 @@ static void update(unsigned entity, entity_list_t *entities, map_t *map)
         { ENTITY_TILE_SIZE / TILE_DRAW_SIZE, ENTITY_TILE_SIZE / TILE_DRAW_SIZE },
     };
 
-    float radius;
-    float angle = vec2ang(player->position.x - base->position.x,
-        player->position.y - base->position.y);
+    const float half = ENTITY_TILE_SIZE / TILE_DRAW_SIZE / 2;
 
-    float start_angle = base->direction - slime->view.field / 2.0;
-    float end_angle = base->direction + slime->view.field / 2.0;
-
-    static float hit_player = 0;
-
-    if (end_angle > UTILS_PI * 2)
-        end_angle -= UTILS_PI * 2;
+    // From the slime to a point of the player, and the direction of the slime
+    // once a point is near enough to need it.
+    Vector2 sight;
+    Vector2 facing = { 0, 0 };
+    float radius;
 
-    if (start_angle < 0)
-        start_angle += UTILS_PI * 2;
+    Vector2 heading;
 
     switch (base->state) {
     case ENTITY_STATE_SPAWN:
-        base->frame.max = slime->spritesheet.spawn.width / ENTITY_SPRITE_SIZE;
-
-        if (base->frame.current + 1 == base->frame.max) {
+        if (base->frame.last)
             base->state = ENTITY_STATE_IDLE;
-            base->frame.current = 0;
-        }
 
         break;
 
     case ENTITY_STATE_MOVING:
-        base->frame.max = slime->spritesheet.moving.width / ENTITY_SPRITE_SIZE;
+        // The direction is chosen on the first tick that the slime thinks
+        // before the walk, whatever the frame is then, out of the ticks to
+        // think it keeps on its direction.
+        if (base->frame.current <= 3 && base->ai.think && !slime->headed) {
+            slime->headed = true;
 
-        if (base->frame.current == 0) {
             if (slime->view.target_player)
-                base->direction = angle;
-            else if (rand() / (double) RAND_MAX <= 0.5)
-                base->direction = deg2rad(rand() % 360);
+                base->direction = chase(base, player, context);
+            else if (random_float(&base->ai_random) <= 0.5)
+                base->direction = deg2rad(random_bounded(&base->ai_random,
+                        360));
         } else if (base->frame.current > 3) {
-            next_position.x += base->velocity * cos(base->direction)
-                * GetFrameTime();
-
-            next_position.y += base->velocity * sin(base->direction)
-                * GetFrameTime();
-
-            for (int i = 0; i < 4; i++) {
-                for (int layer = 0; layer < MAP_MAX_LAYERS; layer++) {
-                    if (tile_collision(map_tile(map, layer,
-                                    next_position.x + bounds[i].x,
-                                    base->position.y + bounds[i].y)))
-                        next_position.x = base->position.x;
-
-                    if (tile_collision(map_tile(map, layer,
-                                    base->position.x + bounds[i].x,
-                                    next_position.y + bounds[i].y)))
-                        next_position.y = base->position.y;
-                }
-            }
+            // Keep on the walk while it turns around the obstacles
+            if (base->ai.think)
+                base->direction = slime->view.target_player ?
+                    chase(base, player, context) : wander(base, context);
+
+            heading = fastmath_unit(base->direction);
+
+            base->motion.x = base->velocity * heading.x * game_tick_delta();
+            base->motion.y = base->velocity * heading.y * game_tick_delta();
+
+            next_position.x += base->motion.x;
+            next_position.y += base->motion.y;
 
             // Attack the player
             if (CheckCollisionRecs((Rectangle) {
@@ -165,96 +201,73 @@ static void update(unsigned entity, entity_list_t *entities, map_t *map)
                         bounds[3].x, bounds[3].y }, (Rectangle) {
                             player->position.x, player->position.y,
                             bounds[3].x, bounds[3].y })) {
-                player->state = ENTITY_STATE_DAMAGING;
-                player->frame.current = 0;
+                entity_hit(context, (entity_hit_t) {
+                    .source = index,
+                    .target = 0,
 
-                player->damage_direction = base->direction;
+                    .damage = max((base->attack - player->defense)
+                        * random_bounded(&base->combat_random, 2), 5),
+                    .direction = base->direction,
 
-                if (hit_player == 0) {
-                    player->hearts -= max((base->attack - player->defense)
-                        * (rand() % 2), 5);
+                    .cooldown = true,
+                    .turn = false,
+                });
 
+                if (!player->hitted)
                     base->state = ENTITY_STATE_IDLE;
-                    base->frame.current = 0;
-
-                    hit_player = GetTime();
-                }
 
-                next_position = base->position;
+                base->motion = (Vector2) { 0, 0 };
             }
         }
 
-        if (base->frame.current + 1 == base->frame.max) {
+        if (base->frame.last)
             base->state = ENTITY_STATE_IDLE;
-            base->frame.current = 0;
-        }
-
-        base->position = next_position;
 
         break;
 
     case ENTITY_STATE_DAMAGING:
-        base->frame.max = slime->spritesheet.damaging.width / ENTITY_SPRITE_SIZE;
-
-        next_position.x += (base->velocity / 3) * cos(base->damage_direction)
-            * GetFrameTime();
-        next_position.y += (base->velocity / 3) * sin(base->damage_direction)
-            * GetFrameTime();
-
-        for (int i = 0; i < 4; i++) {
-            for (int layer = 0; layer < MAP_MAX_LAYERS; layer++) {
-                if (tile_collision(map_tile(map, layer,
-                                next_position.x + bounds[i].x,
-                                base->position.y + bounds[i].y)))
-                    next_position.x = base->position.x;
-
-                if (tile_collision(map_tile(map, layer,
-                                base->position.x + bounds[i].x,
-                                next_position.y + bounds[i].y)))
-                    next_position.y = base->position.y;
-            }
-        }
+        heading = fastmath_unit(base->damage_direction);
 
-        base->position = next_position;
+        base->motion.x = (base->velocity / 3) * heading.x * game_tick_delta();
+        base->motion.y = (base->velocity / 3) * heading.y * game_tick_delta();
 
-        if (base->frame.current + 1 == base->frame.max) {
+        if (base->frame.last)
             base->state = ENTITY_STATE_IDLE;
-            base->frame.current = 0;
-        }
 
         break;
 
     case ENTITY_STATE_IDLE:
-        base->frame.max = slime->spritesheet.idle.width / ENTITY_SPRITE_SIZE;
-
-        if (((rand() / (double) RAND_MAX) <= 0.008 || slime->view.target_player)
-                && hit_player == 0) {
+        if (base->ai.think && (random_float(&base->ai_random)
+                    <= 0.008 * base->ai.think || slime->view.target_player)
+                && !player->hitted) {
             base->state = ENTITY_STATE_MOVING;
-            base->frame.current = 0;
+            slime->headed = false;
         }
 
         break;
     }
 
-    if (hit_player > 0 && GetTime() - hit_player >= 0.3)
-        hit_player = 0;
+    // Targeting the player is a decision too
+    if (!base->ai.think)
+        return;
 
-    // Player targeting
+    // Player targeting, a point of the player is seen when it's near, inside
+    // the field and no obstacle is on the way. The ray is cast only for the
+    // points that pass the other tests.
     for (int i = 0; i < 4; i++) {
-        radius = SQ(player->position.x + bounds[i].x - base->position.x)
-            + SQ(player->position.y + bounds[i].y - base->position.y);
+        sight.x = player->position.x + bounds[i].x - base->position.x;
+        sight.y = player->position.y + bounds[i].y - base->position.y;
+        radius = SQ(sight.x) + SQ(sight.y);
 
         if (radius <= SQ(slime->view.radius)) {
-            if (i > 0)
-                angle = vec2ang(player->position.x + bounds[i].x - base->position.x,
-                    player->position.y + bounds[i].y - base->position.y);
-
-            if (start_angle > end_angle
-                    && ((start_angle < angle && angle < UTILS_PI * 2)
-                        || (angle < end_angle))) {
-                slime->view.target_player = true;
-                break;
-            } else if (start_angle < angle && angle < end_angle) {
+            if (facing.x == 0 && facing.y == 0)
+                facing = fastmath_unit(base->direction);
+
+            if (sight.x * facing.x + sight.y * facing.y
+                    >= slime->view.cosine * sqrtf(radius)
+                    && raycast_visible(context->map, base->position.x + half,
+                        base->position.y + half, base->position.x + sight.x,
+                        base->position.y + sight.y)) {
                 slime->view.target_player = true;
                 break;
             }
@@ -262,25 +275,83 @@ static void update(unsigned entity, entity_list_t *entities, map_t *map)
             slime->view.target_player = false;
         }
     }
+
+    base->ai.engaged = slime->view.target_player;
 }
 
-static void draw(entity_t *base, Rectangle camera)
+// Direction to the center of the next tile on the walk to the player, or
+// straight to the player when the slime is on its tile or there is no walk.
+// The walks out of the field, or that leave it, follow the path of the slime.
+static float chase(entity_t *base, const entity_t *player,
+    entity_context_t *context)
 {
-    slime_t *slime = (slime_t *) base;
+    const float half = ENTITY_TILE_SIZE / TILE_DRAW_SIZE / 2;
 
-    Texture spritesheet;
+    Vector2 center = { base->position.x + half, base->position.y + half };
+    int next_x, next_y;
 
-    Rectangle sprite = {
-        .x = base->frame.current * ENTITY_SPRITE_SIZE,
-        .y = 0,
+    if (!flowfield_next(context->flow, center.x, center.y, &next_x, &next_y)
+            && (context->hpa == NULL || !walk((slime_t *) base, center.x,
+                    center.y, player->position.x + half,
+                    player->position.y + half, context->hpa, &next_x,
+                    &next_y)))
+        return fastmath_angle(player->position.x - base->position.x,
+            player->position.y - base->position.y);
 
-        .width = ENTITY_SPRITE_SIZE,
-        .height = ENTITY_SPRITE_SIZE,
-    };
+    return fastmath_angle(next_x + 0.5f - center.x, next_y + 0.5f - center.y);
+}
+
+// Next tile on the path to the goal. The path is only found again when the
+// goal goes to other cluster, near it the field takes the walk, or when the
+// slime left it. A goal that can't be reached isn't searched again until then.
+static bool walk(slime_t *slime, int x, int y, int goal_x, int goal_y,
+    const hpa_t *hpa, int *next_x, int *next_y)
+{
+    const int width = hpa->map->width;
+
+    bool current = slime->path.goal != HPA_NONE
+        && slime->path.generation == hpa->generation
+        && hpa_cluster(hpa, goal_x, goal_y) == hpa_cluster(hpa,
+            slime->path.goal % width, slime->path.goal / width);
+
+    if (current && list_size(slime->path.waypoints) == 0)
+        return false;
+
+    if (current && hpa_next(hpa, &slime->path, x, y, next_x, next_y))
+        return true;
+
+    return hpa_find(hpa, &slime->path, x, y, goal_x, goal_y)
+        && hpa_next(hpa, &slime->path, x, y, next_x, next_y);
+}
+
+// Direction of a wandering slime, turned away from the obstacle ahead of it
+// instead of pushing against it.
+static float wander(entity_t *base, entity_context_t *context)
+{
+    const float half = ENTITY_TILE_SIZE / TILE_DRAW_SIZE / 2;
+
+    Vector2 center = { base->position.x + half, base->position.y + half };
+    Vector2 heading = fastmath_unit(base->direction);
+    float direction;
+
+    if (context->clearance == NULL || clearance_at(context->clearance,
+                center.x + heading.x * SLIME_WANDER_AHEAD,
+                center.y + heading.y * SLIME_WANDER_AHEAD) >= 1)
+        return base->direction;
+
+    if (clearance_away(context->clearance, center.x, center.y, &direction))
+        return direction;
+
+    return fmod(base->direction + UTILS_PI, UTILS_PI * 2);
+}
+
+static void draw(entity_t *base, Vector2 position, Rectangle camera)
+{
+    Rectangle sprite = base->frame.source;
 
     Rectangle tile = {
-        .x = (base->position.x - camera.x) * TILE_DRAW_SIZE,
-        .y = (base->position.y - camera.y) * TILE_DRAW_SIZE,
+        .x = (position.x - camera.x) * TILE_DRAW_SIZE,
+        .y = (position.y - camera.y) * TILE_DRAW_SIZE,
 
         .width = ENTITY_TILE_SIZE,
         .height = ENTITY_TILE_SIZE,
@@ -293,24 +364,6 @@ static void draw(entity_t *base, Rectangle camera)
         .height = ENTITY_HEART_BAR_HEIGHT,
     };
 
-    switch (base->state) {
-    case ENTITY_STATE_SPAWN:
-        spritesheet = slime->spritesheet.spawn;
-        break;
-
-    case ENTITY_STATE_MOVING:
-        spritesheet = slime->spritesheet.moving;
-        break;
-
-    case ENTITY_STATE_DAMAGING:
-        spritesheet = slime->spritesheet.damaging;
-        break;
-
-    case ENTITY_STATE_IDLE:
-        spritesheet = slime->spritesheet.idle;
-        break;
-    }
-
     if (base->direction > deg2rad(90) && base->direction < deg2rad(270))
         sprite.width = -sprite.width;
 
@@ -324,11 +377,21 @@ static void draw(entity_t *base, Rectangle camera)
         DrawRectangleLinesEx(heart_bar_rect, 1, BLACK);
     }
 
-    DrawTexturePro(spritesheet, sprite, tile, (Vector2) { 0, 0 }, 0, WHITE);
+    DrawTexturePro(animation_texture(base->animation, &base->frame), sprite,
+        tile, (Vector2) { 0, 0 }, 0, WHITE);
 }
 
 static void destroy(entity_t *entity)
 {
+    hpa_path_destroy(&((slime_t *) entity)->path);
     free((slime_t *) entity);
 }
 
+static const animation_table_t *slime_animation(void)
+{
+    if (g_slime.animation.count == 0)
+        animation_table_create(&g_slime.animation, slime_clips,
+            sizeof(slime_clips) / sizeof(slime_clips[0]));
+
+    return &g_slime.animation;
+}
@@ -24,16 +24,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <string.h>
 #include "game.h"
 #include "utils/list.h"
+#include "utils/random.h"
 #include "utils/utils.h"
 #include "world/entity/entity.h"
 #include "world/entity/spawner.h"
 #include "world/entity/player.h"
 
-#define RANDINT(min, max) ((min) + rand() % ((max) - (min) + 1))
 #define SPAWMER_SPAWN_RADIUS 5
 
+// Positions tried for each entity before it's left to the next update
+#define SPAWNER_SPAWN_ATTEMPTS 16
+
 static FILE *spawner_goto_section(void);
-static Vector2 spawner_entity_position(Vector2 center, float radius);
+static bool spawner_entity_position(Vector2 center, float radius,
+    const clearance_t *clearance, Vector2 *position);
 
 void spawner_create(spawner_list_t *spawners)
 {
@@ -107,13 +111,15 @@ void spawner_destroy(spawner_list_t *spawners)
 
 // Placeholder
 entity_t *slime_create(Vector2 position);
-void spawner_update(spawner_list_t *spawners, entity_list_t *entities)
+void spawner_update(spawner_list_t *spawners, entity_list_t *entities,
+    const clearance_t *clearance)
 {
     spawner_t *spawner;
     entity_t  *player = list_get(*entities, 0);
 
     Vector2 spawn_entity_pos;
-    int entities_to_spawn;
+    int entities_to_spawn, attempts;
+    bool placed;
 
     for (unsigned i = 0; i < list_size(*spawners); i++) {
         spawner = &list_get(*spawners, i);
@@ -132,8 +138,9 @@ void spawner_update(spawner_list_t *spawners, entity_list_t *entities)
             // This will be calculated once when the spawner->spawned_entities
             // is zero at first time, next times that is zero it'll generated
             // the entities until reach this value again.
-            spawner->max_spawned_entities = RANDINT(spawner->spawn_min_entities,
-                    spawner->spawn_max_entities);
+            spawner->max_spawned_entities = random_range(
+                game_random(RANDOM_STREAM_SPAWNING),
+                spawner->spawn_min_entities, spawner->spawn_max_entities);
         }
 
         entities_to_spawn = spawner->max_spawned_entities
@@ -143,12 +150,15 @@ void spawner_update(spawner_list_t *spawners, entity_list_t *entities)
 
         for (int j = 0, k = 0; j < entities_to_spawn; j++) {
             // This do-while will select a valid position for the new entity
-            // generated.
+            // generated, the ones that don't find it are spawned on the next
+            // updates as the spawner counts its entities again.
+            attempts = 0;
+
             do {
-                spawn_entity_pos = spawner_entity_position(spawner->position,
-                    spawner->spawn_radius);
+                placed = spawner_entity_position(spawner->position,
+                    spawner->spawn_radius, clearance, &spawn_entity_pos);
 
-                for (k = list_size(*entities) - 1; k > 0; k--)
+                for (k = list_size(*entities) - 1; placed && k > 0; k--)
                     if (list_get(*entities, k)->spawner_id == i &&
                         CheckCollisionRecs(
                             (Rectangle) {
@@ -163,7 +173,10 @@ void spawner_update(spawner_list_t *spawners, entity_list_t *entities)
                             })
                         )
                         break;
-            } while (k > 0);
+            } while ((!placed || k > 0) && ++attempts < SPAWNER_SPAWN_ATTEMPTS);
+
+            if (!placed || k > 0)
+                continue;
 
             list_add(*entities, slime_create(spawn_entity_pos));
             list_get(*entities, list_size(*entities) - 1)->spawner_id = i;
@@ -176,10 +189,10 @@ void spawner_new(spawner_list_t *spawners, Vector2 position)
     spawner_t spawner = (spawner_t) {
         .position = position,
 
-        .spawn_min_entities = 3,
-        .spawn_max_entities = 8,
+        .spawn_min_entities = SPAWNER_DEFAULT_MIN_ENTITIES,
+        .spawn_max_entities = SPAWNER_DEFAULT_MAX_ENTITIES,
 
-        .spawn_radius = 3,
+        .spawn_radius = SPAWNER_DEFAULT_RADIUS,
 
         .spawned_entities = 0,
     };
@@ -278,18 +291,36 @@ static FILE *spawner_goto_section(void)
     return (file = game_file("a"));
 }
 
-static Vector2 spawner_entity_position(Vector2 center, float radius)
+static bool spawner_entity_position(Vector2 center, float radius,
+    const clearance_t *clearance, Vector2 *position)
 {
+    const float half = ENTITY_TILE_SIZE / TILE_DRAW_SIZE / 2;
+
+    random_t *random = game_random(RANDOM_STREAM_SPAWNING);
     double x, y;
+    int tile_x, tile_y;
 
     do {
-        x = (rand() / (double) RAND_MAX) * 2.0 - 1.0;
-        y = (rand() / (double) RAND_MAX) * 2.0 - 1.0;
+        x = random_double(random) * 2.0 - 1.0;
+        y = random_double(random) * 2.0 - 1.0;
     } while ((x * x) + (y * y) > 1);
 
-    return (Vector2) {
+    *position = (Vector2) {
         .x = x * radius + center.x,
         .y = y * radius + center.y,
     };
+
+    if (clearance == NULL)
+        return true;
+
+    // Any tile that doesn't collide holds the whole entity on its center
+    if (!clearance_nearest(clearance, floor(position->x), floor(position->y),
+                1, radius, &tile_x, &tile_y))
+        return false;
+
+    position->x = tile_x + 0.5 - half;
+    position->y = tile_y + 0.5 - half;
+
+    return true;
 }
 
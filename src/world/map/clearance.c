@@ -0,0 +1,174 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "utils/fastmath.h"
+#include "utils/utils.h"
+#include "world/map/clearance.h"
+#include "world/map/map.h"
+#include "world/map/tile.h"
+
+static void clearance_passes(clearance_t *clearance, int x0, int y0, int x1,
+    int y1);
+static int  clearance_get(const clearance_t *clearance, int x, int y);
+
+void clearance_create(clearance_t *clearance, map_t *map)
+{
+    clearance->map = map;
+    clearance->distances = malloc(sizeof(uint8_t) * map->width * map->height);
+
+    clearance_passes(clearance, 0, 0, map->width, map->height);
+}
+
+void clearance_destroy(clearance_t *clearance)
+{
+    free(clearance->distances);
+
+    clearance->distances = NULL;
+    clearance->map = NULL;
+}
+
+void clearance_update(clearance_t *clearance, int x, int y)
+{
+    // The tiles out of the window are farther than the distances go, so they
+    // keep their distances and the passes start from them.
+    const int radius = CLEARANCE_MAX / CLEARANCE_SIDE + 1;
+
+    clearance_passes(clearance, max(x - radius, 0), max(y - radius, 0),
+        min(x + radius + 1, clearance->map->width),
+        min(y + radius + 1, clearance->map->height));
+}
+
+float clearance_at(const clearance_t *clearance, float x, float y)
+{
+    return clearance_get(clearance, floor(x), floor(y))
+        / (float) CLEARANCE_SIDE;
+}
+
+bool clearance_nearest(const clearance_t *clearance, int x, int y,
+    float distance, int radius, int *nearest_x, int *nearest_y)
+{
+    const int wanted = ceil(distance * CLEARANCE_SIDE);
+
+    int best = -1;
+
+    // The squares grow by one tile, the nearest to the center wins on each
+    for (int square = 0; square <= radius && best < 0; square++) {
+        for (int dy = -square; dy <= square; dy++) {
+            for (int dx = -square; dx <= square; dx++) {
+                if (max(abs(dx), abs(dy)) != square
+                        || clearance_get(clearance, x + dx, y + dy) < wanted
+                        || (best >= 0 && dx * dx + dy * dy >= best))
+                    continue;
+
+                best = dx * dx + dy * dy;
+                *nearest_x = x + dx;
+                *nearest_y = y + dy;
+            }
+        }
+    }
+
+    return best >= 0;
+}
+
+bool clearance_away(const clearance_t *clearance, float x, float y,
+    float *direction)
+{
+    const int tile_x = floor(x);
+    const int tile_y = floor(y);
+
+    const int dx = clearance_get(clearance, tile_x + 1, tile_y)
+        - clearance_get(clearance, tile_x - 1, tile_y);
+    const int dy = clearance_get(clearance, tile_x, tile_y + 1)
+        - clearance_get(clearance, tile_x, tile_y - 1);
+
+    if (dx == 0 && dy == 0)
+        return false;
+
+    *direction = fastmath_angle(dx, dy);
+
+    return true;
+}
+
+// Make the distances of the tiles [x0, x1) and [y0, y1), the tiles around them
+// must have theirs.
+static void clearance_passes(clearance_t *clearance, int x0, int y0, int x1,
+    int y1)
+{
+    map_t *map = clearance->map;
+
+    int distance;
+
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            clearance_tile(clearance, x, y) = map_collides(map, x, y) ?
+                0 : CLEARANCE_MAX;
+        }
+    }
+
+    // Each tile takes the lowest distance of the neighbors already passed plus
+    // the step to them, first the ones above and on the left.
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            if ((distance = clearance_tile(clearance, x, y)) == 0)
+                continue;
+
+            distance = min(distance,
+                clearance_get(clearance, x - 1, y) + CLEARANCE_SIDE);
+            distance = min(distance,
+                clearance_get(clearance, x, y - 1) + CLEARANCE_SIDE);
+            distance = min(distance,
+                clearance_get(clearance, x - 1, y - 1) + CLEARANCE_DIAGONAL);
+            distance = min(distance,
+                clearance_get(clearance, x + 1, y - 1) + CLEARANCE_DIAGONAL);
+
+            clearance_tile(clearance, x, y) = distance;
+        }
+    }
+
+    for (int y = y1 - 1; y >= y0; y--) {
+        for (int x = x1 - 1; x >= x0; x--) {
+            if ((distance = clearance_tile(clearance, x, y)) == 0)
+                continue;
+
+            distance = min(distance,
+                clearance_get(clearance, x + 1, y) + CLEARANCE_SIDE);
+            distance = min(distance,
+                clearance_get(clearance, x, y + 1) + CLEARANCE_SIDE);
+            distance = min(distance,
+                clearance_get(clearance, x + 1, y + 1) + CLEARANCE_DIAGONAL);
+            distance = min(distance,
+                clearance_get(clearance, x - 1, y + 1) + CLEARANCE_DIAGONAL);
+
+            clearance_tile(clearance, x, y) = distance;
+        }
+    }
+}
+
+static int clearance_get(const clearance_t *clearance, int x, int y)
+{
+    if (x < 0 || x >= clearance->map->width || y < 0
+            || y >= clearance->map->height)
+        return 0;
+
+    return clearance_tile(clearance, x, y);
+}
@@ -0,0 +1,134 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "world/map/flowfield.h"
+#include "world/map/map.h"
+#include "world/map/tile.h"
+
+void flowfield_create(flowfield_t *field, int radius)
+{
+    field->map = NULL;
+
+    field->radius = radius;
+    field->size = radius * 2 + 1;
+
+    field->target_x = field->target_y = 0;
+    field->x = field->y = 0;
+
+    field->next = malloc(sizeof(int8_t) * field->size * field->size);
+    field->steps = malloc(sizeof(uint16_t) * field->size * field->size);
+    field->queue = malloc(sizeof(int) * field->size * field->size);
+}
+
+void flowfield_destroy(flowfield_t *field)
+{
+    free(field->next);
+    free(field->steps);
+    free(field->queue);
+
+    field->next = NULL;
+    field->steps = NULL;
+    field->queue = NULL;
+
+    field->map = NULL;
+}
+
+bool flowfield_update(flowfield_t *field, map_t *map, int x, int y)
+{
+    const int size = field->size;
+
+    int head = 0, tail = 0;
+    int tile, tile_x, tile_y;
+    int from, from_x, from_y;
+
+    if (field->map == map && field->target_x == x && field->target_y == y)
+        return false;
+
+    field->map = map;
+    field->target_x = x;
+    field->target_y = y;
+    field->x = x - field->radius;
+    field->y = y - field->radius;
+
+    for (int i = 0; i < size * size; i++) {
+        field->next[i] = FLOWFIELD_NONE;
+        field->steps[i] = FLOWFIELD_UNREACHED;
+    }
+
+    tile = field->radius * size + field->radius;
+    field->steps[tile] = 0;
+    field->queue[tail++] = tile;
+
+    // Each tile reached is the next tile of the ones around it that can walk
+    // to it and weren't reached yet.
+    while (head < tail) {
+        tile = field->queue[head++];
+        tile_x = tile % size;
+        tile_y = tile / size;
+
+        for (int direction = 0; direction < MAP_DIRECTIONS; direction++) {
+            from_x = tile_x - map_direction_x[direction];
+            from_y = tile_y - map_direction_y[direction];
+            from = from_y * size + from_x;
+
+            if (from_x < 0 || from_x >= size || from_y < 0 || from_y >= size
+                    || field->steps[from] != FLOWFIELD_UNREACHED
+                    || map_collides(map, field->x + from_x,
+                        field->y + from_y))
+                continue;
+
+            if (direction >= 4 && (map_collides(map,
+                            field->x + tile_x, field->y + from_y)
+                        || map_collides(map, field->x + from_x,
+                            field->y + tile_y)))
+                continue;
+
+            field->next[from] = direction;
+            field->steps[from] = field->steps[tile] + 1;
+            field->queue[tail++] = from;
+        }
+    }
+
+    return true;
+}
+
+bool flowfield_next(const flowfield_t *field, int x, int y, int *next_x,
+    int *next_y)
+{
+    int direction;
+
+    x -= field->x;
+    y -= field->y;
+
+    if (field->map == NULL || x < 0 || x >= field->size || y < 0
+            || y >= field->size)
+        return false;
+
+    if ((direction = field->next[y * field->size + x]) == FLOWFIELD_NONE)
+        return false;
+
+    *next_x = field->x + x + map_direction_x[direction];
+    *next_y = field->y + y + map_direction_y[direction];
+
+    return true;
+}
@@ -0,0 +1,774 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "utils/list.h"
+#include "utils/utils.h"
+#include "utils/workers.h"
+#include "world/map/hpa.h"
+#include "world/map/map.h"
+#include "world/map/tile.h"
+
+// Tiles of the largest box searched, the 4 clusters around a corner
+#define HPA_BOX_TILES (4 * HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE)
+
+// Tiles [x0, x1) and [y0, y1) of the map
+typedef struct {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+} hpa_box_t;
+
+// Binary heap of the items with the lowest key first, it keeps the position
+// of each item so their keys can be lowered.
+typedef struct {
+    int       *items;
+    int       *positions;
+    const int *keys;
+    int        count;
+} hpa_heap_t;
+
+// Search on the graph, the nodes after the ones of the graph are the start
+// and the goal.
+typedef struct {
+    const hpa_t *hpa;
+
+    int *costs;
+    int *keys;
+    int *parents;
+
+    hpa_heap_t heap;
+
+    int goal;
+    int goal_x;
+    int goal_y;
+} hpa_query_t;
+
+static void hpa_build_border(hpa_t *hpa, int cluster, bool below);
+static int  hpa_add_node(hpa_t *hpa, int x, int y, int cluster);
+static void hpa_build_range(void *job, unsigned worker, unsigned first,
+    unsigned last);
+static void hpa_build_cluster(hpa_t *hpa, int cluster);
+
+static hpa_box_t hpa_cluster_box(const hpa_t *hpa, int cluster);
+static void hpa_search(const hpa_t *hpa, hpa_box_t box, int x, int y,
+    int *costs, int8_t *next);
+static void hpa_relax(hpa_query_t *query, int from, int to, int cost);
+static int  hpa_estimate(int x, int y, int goal_x, int goal_y);
+
+static void hpa_heap_update(hpa_heap_t *heap, int item);
+static int  hpa_heap_pop(hpa_heap_t *heap);
+
+void hpa_create(hpa_t *hpa, map_t *map, workers_t *workers)
+{
+    int count;
+
+    hpa->map = map;
+    hpa->columns = (map->width + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE;
+    hpa->rows = (map->height + HPA_CLUSTER_SIZE - 1) / HPA_CLUSTER_SIZE;
+
+    count = hpa->columns * hpa->rows;
+
+    hpa->clusters = malloc(sizeof(hpa_cluster_t) * count);
+    hpa->borders = malloc(sizeof(*hpa->borders) * count * 2);
+
+    hpa->nodes = NULL;
+    hpa->nodes_count = 0;
+    hpa->nodes_capacity = 0;
+
+    list_create(hpa->unused);
+    hpa->generation = 0;
+
+    for (int i = 0; i < count; i++) {
+        hpa->clusters[i] = (hpa_cluster_t) { NULL, 0, NULL };
+
+        list_create(hpa->borders[i * 2]);
+        list_create(hpa->borders[i * 2 + 1]);
+    }
+
+    // The portals are few and found on one pass over the borders, only the
+    // costs inside the clusters are split between the workers.
+    for (int i = 0; i < count; i++) {
+        hpa_build_border(hpa, i, false);
+        hpa_build_border(hpa, i, true);
+    }
+
+    workers_run(workers, count, hpa_build_range, hpa);
+}
+
+void hpa_destroy(hpa_t *hpa)
+{
+    for (int i = 0; i < hpa->columns * hpa->rows; i++) {
+        free(hpa->clusters[i].nodes);
+        free(hpa->clusters[i].costs);
+
+        list_destroy(hpa->borders[i * 2]);
+        list_destroy(hpa->borders[i * 2 + 1]);
+    }
+
+    free(hpa->clusters);
+    free(hpa->borders);
+    free(hpa->nodes);
+
+    list_destroy(hpa->unused);
+
+    hpa->clusters = NULL;
+    hpa->borders = NULL;
+    hpa->nodes = NULL;
+
+    hpa->columns = hpa->rows = 0;
+    hpa->nodes_count = hpa->nodes_capacity = 0;
+}
+
+void hpa_repair(hpa_t *hpa, int x, int y)
+{
+    const int cluster = hpa_cluster(hpa, x, y);
+    const int column = cluster % hpa->columns;
+    const int row = cluster / hpa->columns;
+
+    // The tile only changes the borders of its cluster, and the costs of the
+    // clusters with nodes on them.
+    hpa_build_border(hpa, cluster, false);
+    hpa_build_border(hpa, cluster, true);
+
+    if (column > 0)
+        hpa_build_border(hpa, cluster - 1, false);
+
+    if (row > 0)
+        hpa_build_border(hpa, cluster - hpa->columns, true);
+
+    hpa_build_cluster(hpa, cluster);
+
+    if (column > 0)
+        hpa_build_cluster(hpa, cluster - 1);
+
+    if (column + 1 < hpa->columns)
+        hpa_build_cluster(hpa, cluster + 1);
+
+    if (row > 0)
+        hpa_build_cluster(hpa, cluster - hpa->columns);
+
+    if (row + 1 < hpa->rows)
+        hpa_build_cluster(hpa, cluster + hpa->columns);
+
+    hpa->generation++;
+}
+
+void hpa_path_create(hpa_path_t *path)
+{
+    path->goal = HPA_NONE;
+    path->generation = 0;
+
+    list_create(path->waypoints);
+    path->waypoint = 0;
+
+    list_create(path->leg);
+}
+
+void hpa_path_destroy(hpa_path_t *path)
+{
+    list_destroy(path->waypoints);
+    list_destroy(path->leg);
+}
+
+bool hpa_find(const hpa_t *hpa, hpa_path_t *path, int x, int y, int goal_x,
+    int goal_y)
+{
+    const int width = hpa->map->width;
+    const int start = hpa->nodes_count;
+    const int goal = hpa->nodes_count + 1;
+
+    const hpa_cluster_t *from, *to;
+    hpa_box_t from_box, to_box;
+
+    int tiles[HPA_BOX_TILES];
+    int *start_costs, *goal_costs, *buffer;
+    int direct, count, node;
+
+    hpa_query_t query;
+    const hpa_node_t *current;
+    const hpa_cluster_t *cluster;
+
+    path->goal = goal_y * width + goal_x;
+    path->generation = hpa->generation;
+
+    list_empty(path->waypoints);
+    list_empty(path->leg);
+    path->waypoint = 0;
+
+    if (map_collides(hpa->map, x, y)
+            || map_collides(hpa->map, goal_x, goal_y))
+        return false;
+
+    from = &hpa->clusters[hpa_cluster(hpa, x, y)];
+    to = &hpa->clusters[hpa_cluster(hpa, goal_x, goal_y)];
+    from_box = hpa_cluster_box(hpa, hpa_cluster(hpa, x, y));
+    to_box = hpa_cluster_box(hpa, hpa_cluster(hpa, goal_x, goal_y));
+
+    count = hpa->nodes_count + 2;
+    buffer = malloc(sizeof(int) * (count * 5 + from->count + to->count));
+
+    query = (hpa_query_t) {
+        .hpa = hpa,
+
+        .costs = buffer,
+        .keys = buffer + count,
+        .parents = buffer + count * 2,
+
+        .heap = {
+            .items = buffer + count * 3,
+            .positions = buffer + count * 4,
+            .keys = buffer + count,
+            .count = 0,
+        },
+
+        .goal = goal,
+        .goal_x = goal_x,
+        .goal_y = goal_y,
+    };
+
+    start_costs = buffer + count * 5;
+    goal_costs = start_costs + from->count;
+
+    // The start and the goal join the graph by the walks inside their
+    // clusters, the walks are the same on both ways so both searches start
+    // from their tile.
+    hpa_search(hpa, from_box, x, y, tiles, NULL);
+
+    for (int i = 0; i < from->count; i++) {
+        current = &hpa->nodes[from->nodes[i]];
+        start_costs[i] = tiles[(current->y - from_box.y0)
+            * (from_box.x1 - from_box.x0) + current->x - from_box.x0];
+    }
+
+    direct = from != to ? HPA_UNREACHED : tiles[(goal_y - from_box.y0)
+        * (from_box.x1 - from_box.x0) + goal_x - from_box.x0];
+
+    hpa_search(hpa, to_box, goal_x, goal_y, tiles, NULL);
+
+    for (int i = 0; i < to->count; i++) {
+        current = &hpa->nodes[to->nodes[i]];
+        goal_costs[i] = tiles[(current->y - to_box.y0)
+            * (to_box.x1 - to_box.x0) + current->x - to_box.x0];
+    }
+
+    for (int i = 0; i < count; i++) {
+        query.costs[i] = HPA_UNREACHED;
+        query.parents[i] = HPA_NONE;
+        query.heap.positions[i] = HPA_NONE;
+    }
+
+    query.costs[start] = 0;
+    query.keys[start] = hpa_estimate(x, y, goal_x, goal_y);
+    hpa_heap_update(&query.heap, start);
+
+    while (query.heap.count > 0) {
+        node = hpa_heap_pop(&query.heap);
+
+        if (node == goal)
+            break;
+
+        if (node == start) {
+            for (int i = 0; i < from->count; i++)
+                hpa_relax(&query, start, from->nodes[i], start_costs[i]);
+
+            hpa_relax(&query, start, goal, direct);
+            continue;
+        }
+
+        current = &hpa->nodes[node];
+        cluster = &hpa->clusters[current->cluster];
+
+        hpa_relax(&query, node, current->pair, HPA_COST_SIDE);
+
+        for (int i = 0; i < cluster->count; i++) {
+            if (i != current->index)
+                hpa_relax(&query, node, cluster->nodes[i],
+                    cluster->costs[current->index * cluster->count + i]);
+        }
+
+        if (cluster == to)
+            hpa_relax(&query, node, goal, goal_costs[current->index]);
+    }
+
+    if (query.costs[goal] != HPA_UNREACHED) {
+        for (node = goal; node != HPA_NONE; node = query.parents[node]) {
+            if (node == goal)
+                list_add(path->waypoints, path->goal);
+            else if (node == start)
+                list_add(path->waypoints, y * width + x);
+            else
+                list_add(path->waypoints, hpa->nodes[node].y * width
+                    + hpa->nodes[node].x);
+        }
+
+        // The parents go from the goal to the start
+        for (unsigned i = 0; i < list_size(path->waypoints) / 2; i++) {
+            node = list_get(path->waypoints, i);
+            list_set(path->waypoints, i, list_get(path->waypoints,
+                    list_size(path->waypoints) - 1 - i));
+            list_set(path->waypoints, list_size(path->waypoints) - 1 - i,
+                node);
+        }
+
+        path->waypoint = 1;
+    }
+
+    free(buffer);
+
+    return list_size(path->waypoints) > 0;
+}
+
+bool hpa_next(const hpa_t *hpa, hpa_path_t *path, int x, int y, int *next_x,
+    int *next_y)
+{
+    const int width = hpa->map->width;
+    const int tile = y * width + x;
+
+    int target, target_x, target_y, direction;
+    int costs[HPA_BOX_TILES];
+    int8_t next[HPA_BOX_TILES];
+    hpa_box_t box;
+
+    if (path->generation != hpa->generation)
+        return false;
+
+    for (unsigned i = 0; i + 1 < list_size(path->leg); i++) {
+        if (list_get(path->leg, i) == tile) {
+            *next_x = list_get(path->leg, i + 1) % width;
+            *next_y = list_get(path->leg, i + 1) / width;
+            return true;
+        }
+    }
+
+    while (path->waypoint < list_size(path->waypoints)
+            && list_get(path->waypoints, path->waypoint) == tile)
+        path->waypoint++;
+
+    if (path->waypoint >= list_size(path->waypoints))
+        return false;
+
+    target = list_get(path->waypoints, path->waypoint);
+    target_x = target % width;
+    target_y = target / width;
+
+    // The leg is searched on the clusters of the tile and of the waypoint,
+    // these are the same or neighbors while the tile is on the path.
+    if (abs(x / HPA_CLUSTER_SIZE - target_x / HPA_CLUSTER_SIZE) > 1
+            || abs(y / HPA_CLUSTER_SIZE - target_y / HPA_CLUSTER_SIZE) > 1)
+        return false;
+
+    box = (hpa_box_t) {
+        .x0 = min(x, target_x) / HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE,
+        .y0 = min(y, target_y) / HPA_CLUSTER_SIZE * HPA_CLUSTER_SIZE,
+        .x1 = min((max(x, target_x) / HPA_CLUSTER_SIZE + 1)
+            * HPA_CLUSTER_SIZE, hpa->map->width),
+        .y1 = min((max(y, target_y) / HPA_CLUSTER_SIZE + 1)
+            * HPA_CLUSTER_SIZE, hpa->map->height),
+    };
+
+    hpa_search(hpa, box, target_x, target_y, costs, next);
+
+    if (costs[(y - box.y0) * (box.x1 - box.x0) + x - box.x0] == HPA_UNREACHED)
+        return false;
+
+    list_empty(path->leg);
+    list_add(path->leg, tile);
+
+    while (x != target_x || y != target_y) {
+        direction = next[(y - box.y0) * (box.x1 - box.x0) + x - box.x0];
+        x += map_direction_x[direction];
+        y += map_direction_y[direction];
+
+        list_add(path->leg, y * width + x);
+    }
+
+    *next_x = list_get(path->leg, 1) % width;
+    *next_y = list_get(path->leg, 1) / width;
+
+    return true;
+}
+
+// Split the runs of tiles that can be walked on both sides of a border on
+// portals, the ones that were on it before are left to the next portals.
+static void hpa_build_border(hpa_t *hpa, int cluster, bool below)
+{
+    const int column = cluster % hpa->columns;
+    const int row = cluster / hpa->columns;
+    const int border = cluster * 2 + below;
+
+    // The border is the last line of the cluster, across it is the neighbor
+    const int x = below ? column * HPA_CLUSTER_SIZE
+        : column * HPA_CLUSTER_SIZE + HPA_CLUSTER_SIZE - 1;
+    const int y = below ? row * HPA_CLUSTER_SIZE + HPA_CLUSTER_SIZE - 1
+        : row * HPA_CLUSTER_SIZE;
+    const int step_x = below, step_y = !below;
+    const int across_x = !below, across_y = below;
+    const int neighbor = below ? cluster + hpa->columns : cluster + 1;
+
+    int length, first = HPA_NONE, portals, at, node, pair;
+    bool open;
+
+    for (unsigned i = 0; i < list_size(hpa->borders[border]); i++) {
+        node = list_get(hpa->borders[border], i);
+        pair = hpa->nodes[node].pair;
+
+        hpa->nodes[node].cluster = hpa->nodes[pair].cluster = HPA_NONE;
+
+        list_add(hpa->unused, node);
+        list_add(hpa->unused, pair);
+    }
+
+    list_empty(hpa->borders[border]);
+
+    if (below ? row + 1 >= hpa->rows : column + 1 >= hpa->columns)
+        return;
+
+    length = below ? min(HPA_CLUSTER_SIZE, hpa->map->width - x)
+        : min(HPA_CLUSTER_SIZE, hpa->map->height - y);
+
+    for (int i = 0; i <= length; i++) {
+        open = i < length
+            && !map_collides(hpa->map, x + i * step_x, y + i * step_y)
+            && !map_collides(hpa->map, x + i * step_x + across_x,
+                y + i * step_y + across_y);
+
+        if (open && first == HPA_NONE)
+            first = i;
+
+        if (open || first == HPA_NONE)
+            continue;
+
+        // A portal on the middle of the narrow entrances, and one on each end
+        // of the wide ones.
+        portals = i - first >= HPA_WIDE_ENTRANCE ? 2 : 1;
+
+        for (int j = 0; j < portals; j++) {
+            if (portals == 1)
+                at = (first + i - 1) / 2;
+            else
+                at = j == 0 ? first : i - 1;
+
+            node = hpa_add_node(hpa, x + at * step_x, y + at * step_y,
+                cluster);
+            pair = hpa_add_node(hpa, x + at * step_x + across_x,
+                y + at * step_y + across_y, neighbor);
+
+            hpa->nodes[node].pair = pair;
+            hpa->nodes[pair].pair = node;
+
+            list_add(hpa->borders[border], node);
+        }
+
+        first = HPA_NONE;
+    }
+}
+
+static int hpa_add_node(hpa_t *hpa, int x, int y, int cluster)
+{
+    int node;
+
+    if (list_size(hpa->unused) > 0) {
+        node = list_get(hpa->unused, list_size(hpa->unused) - 1);
+        hpa->unused.count--;
+    } else {
+        if (hpa->nodes_count + 1 > hpa->nodes_capacity) {
+            hpa->nodes_capacity = hpa->nodes_capacity == 0 ? 32
+                : hpa->nodes_capacity * 2;
+            hpa->nodes = realloc(hpa->nodes,
+                sizeof(hpa_node_t) * hpa->nodes_capacity);
+        }
+
+        node = hpa->nodes_count++;
+    }
+
+    hpa->nodes[node] = (hpa_node_t) {
+        .x = x,
+        .y = y,
+
+        .cluster = cluster,
+        .pair = HPA_NONE,
+        .index = HPA_NONE,
+    };
+
+    return node;
+}
+
+static void hpa_build_range(void *job, unsigned worker, unsigned first,
+    unsigned last)
+{
+    (void) worker;
+
+    for (unsigned i = first; i < last; i++)
+        hpa_build_cluster(job, i);
+}
+
+// Gather the nodes of the cluster and the costs between them
+static void hpa_build_cluster(hpa_t *hpa, int cluster)
+{
+    const int column = cluster % hpa->columns;
+    const int row = cluster / hpa->columns;
+    const hpa_box_t box = hpa_cluster_box(hpa, cluster);
+
+    hpa_cluster_t *current = &hpa->clusters[cluster];
+    const hpa_node_t *from, *to;
+
+    int tiles[HPA_BOX_TILES];
+    int count = 0, cost;
+
+    free(current->nodes);
+    free(current->costs);
+
+    // Its nodes on the borders on the right and below, and the pairs of the
+    // nodes on the borders of the neighbors on the left and above.
+    count += list_size(hpa->borders[cluster * 2]);
+    count += list_size(hpa->borders[cluster * 2 + 1]);
+
+    if (column > 0)
+        count += list_size(hpa->borders[(cluster - 1) * 2]);
+
+    if (row > 0)
+        count += list_size(hpa->borders[(cluster - hpa->columns) * 2 + 1]);
+
+    current->nodes = malloc(sizeof(int) * count);
+    current->costs = malloc(sizeof(int) * count * count);
+    current->count = 0;
+
+    for (unsigned i = 0; i < list_size(hpa->borders[cluster * 2]); i++)
+        current->nodes[current->count++] =
+            list_get(hpa->borders[cluster * 2], i);
+
+    for (unsigned i = 0; i < list_size(hpa->borders[cluster * 2 + 1]); i++)
+        current->nodes[current->count++] =
+            list_get(hpa->borders[cluster * 2 + 1], i);
+
+    for (unsigned i = 0; column > 0
+            && i < list_size(hpa->borders[(cluster - 1) * 2]); i++)
+        current->nodes[current->count++] = hpa->nodes[list_get(
+            hpa->borders[(cluster - 1) * 2], i)].pair;
+
+    for (unsigned i = 0; row > 0
+            && i < list_size(hpa->borders[(cluster - hpa->columns) * 2 + 1]);
+            i++)
+        current->nodes[current->count++] = hpa->nodes[list_get(
+            hpa->borders[(cluster - hpa->columns) * 2 + 1], i)].pair;
+
+    for (int i = 0; i < count; i++)
+        hpa->nodes[current->nodes[i]].index = i;
+
+    // The walks are the same on both ways, each search fills a row and a
+    // column of the costs.
+    for (int i = 0; i < count; i++) {
+        from = &hpa->nodes[current->nodes[i]];
+        current->costs[i * count + i] = 0;
+
+        if (i + 1 < count)
+            hpa_search(hpa, box, from->x, from->y, tiles, NULL);
+
+        for (int j = i + 1; j < count; j++) {
+            to = &hpa->nodes[current->nodes[j]];
+            cost = tiles[(to->y - box.y0) * (box.x1 - box.x0) + to->x - box.x0];
+
+            current->costs[i * count + j] = cost;
+            current->costs[j * count + i] = cost;
+        }
+    }
+}
+
+static hpa_box_t hpa_cluster_box(const hpa_t *hpa, int cluster)
+{
+    const int x = cluster % hpa->columns * HPA_CLUSTER_SIZE;
+    const int y = cluster / hpa->columns * HPA_CLUSTER_SIZE;
+
+    return (hpa_box_t) {
+        .x0 = x,
+        .y0 = y,
+        .x1 = min(x + HPA_CLUSTER_SIZE, hpa->map->width),
+        .y1 = min(y + HPA_CLUSTER_SIZE, hpa->map->height),
+    };
+}
+
+// Costs of the walks from a tile to the tiles of a box, by rows of the box,
+// and the direction of the next tile to it when next isn't NULL. The walks move
+// on the 8 directions without cutting the corners of the tiles that collide.
+static void hpa_search(const hpa_t *hpa, hpa_box_t box, int x, int y,
+    int *costs, int8_t *next)
+{
+    const int width = box.x1 - box.x0;
+    const int height = box.y1 - box.y0;
+
+    bool open[HPA_BOX_TILES];
+    int items[HPA_BOX_TILES];
+    int positions[HPA_BOX_TILES];
+    hpa_heap_t heap = { items, positions, costs, 0 };
+
+    int tile, tile_x, tile_y;
+    int to, to_x, to_y, cost;
+
+    // The tiles are checked once, the search looks at each one many times
+    for (int i = 0; i < width * height; i++) {
+        open[i] = !map_collides(hpa->map, box.x0 + i % width,
+            box.y0 + i / width);
+
+        costs[i] = HPA_UNREACHED;
+        positions[i] = HPA_NONE;
+    }
+
+    tile = (y - box.y0) * width + x - box.x0;
+    costs[tile] = 0;
+    hpa_heap_update(&heap, tile);
+
+    if (next != NULL)
+        next[tile] = HPA_NONE;
+
+    while (heap.count > 0) {
+        tile = hpa_heap_pop(&heap);
+        tile_x = tile % width;
+        tile_y = tile / width;
+
+        for (int direction = 0; direction < MAP_DIRECTIONS; direction++) {
+            to_x = tile_x + map_direction_x[direction];
+            to_y = tile_y + map_direction_y[direction];
+            to = to_y * width + to_x;
+
+            if (to_x < 0 || to_x >= width || to_y < 0 || to_y >= height
+                    || !open[to])
+                continue;
+
+            if (direction >= 4 && (!open[tile_y * width + to_x]
+                        || !open[to_y * width + tile_x]))
+                continue;
+
+            cost = costs[tile] + (direction < 4 ? HPA_COST_SIDE
+                : HPA_COST_DIAGONAL);
+
+            if (cost >= costs[to])
+                continue;
+
+            costs[to] = cost;
+            hpa_heap_update(&heap, to);
+
+            // The opposite direction, back to the tile
+            if (next != NULL)
+                next[to] = direction < 4 ? (direction + 2) % 4
+                    : (direction - 2) % 4 + 4;
+        }
+    }
+}
+
+static void hpa_relax(hpa_query_t *query, int from, int to, int cost)
+{
+    const hpa_node_t *node;
+
+    if (cost == HPA_UNREACHED
+            || (cost += query->costs[from]) >= query->costs[to])
+        return;
+
+    query->costs[to] = cost;
+    query->parents[to] = from;
+
+    if (to == query->goal) {
+        query->keys[to] = cost;
+    } else {
+        node = &query->hpa->nodes[to];
+        query->keys[to] = cost + hpa_estimate(node->x, node->y, query->goal_x,
+            query->goal_y);
+    }
+
+    hpa_heap_update(&query->heap, to);
+}
+
+// Cost of the walk without obstacles, it's never above the real one
+static int hpa_estimate(int x, int y, int goal_x, int goal_y)
+{
+    const int dx = abs(goal_x - x);
+    const int dy = abs(goal_y - y);
+
+    return HPA_COST_SIDE * max(dx, dy)
+        + (HPA_COST_DIAGONAL - HPA_COST_SIDE) * min(dx, dy);
+}
+
+// Insert the item or move it up after its key was lowered, the ties go to the
+// lowest item so the searches don't depend on the order of the insertions.
+static void hpa_heap_update(hpa_heap_t *heap, int item)
+{
+    int position = heap->positions[item], parent;
+
+    if (position == HPA_NONE)
+        position = heap->count++;
+
+    while (position > 0) {
+        parent = heap->items[(position - 1) / 2];
+
+        if (heap->keys[parent] < heap->keys[item]
+                || (heap->keys[parent] == heap->keys[item] && parent < item))
+            break;
+
+        heap->items[position] = parent;
+        heap->positions[parent] = position;
+        position = (position - 1) / 2;
+    }
+
+    heap->items[position] = item;
+    heap->positions[item] = position;
+}
+
+static int hpa_heap_pop(hpa_heap_t *heap)
+{
+    const int top = heap->items[0];
+    const int last = heap->items[--heap->count];
+
+    int position = 0, child;
+
+    heap->positions[top] = HPA_NONE;
+
+    if (heap->count == 0)
+        return top;
+
+    for (;;) {
+        child = position * 2 + 1;
+
+        if (child >= heap->count)
+            break;
+
+        if (child + 1 < heap->count && (heap->keys[heap->items[child + 1]]
+                    < heap->keys[heap->items[child]]
+                    || (heap->keys[heap->items[child + 1]]
+                        == heap->keys[heap->items[child]]
+                        && heap->items[child + 1] < heap->items[child])))
+            child++;
+
+        if (heap->keys[last] < heap->keys[heap->items[child]]
+                || (heap->keys[last] == heap->keys[heap->items[child]]
+                    && last < heap->items[child]))
+            break;
+
+        heap->items[position] = heap->items[child];
+        heap->positions[heap->items[position]] = position;
+        position = child;
+    }
+
+    heap->items[position] = last;
+    heap->positions[last] = position;
+
+    return top;
+}
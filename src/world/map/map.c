@@ -21,10 +21,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include "game.h"
 #include "world/map/map.h"
 
-static FILE *map_goto_section(void);
+// Bytes of each change on the save
+#define MAP_EDIT_SIZE (3 * sizeof(int) + sizeof(tile_t))
+
+const int map_direction_x[MAP_DIRECTIONS] = { 1, 0, -1, 0, 1, -1, -1, 1 };
+const int map_direction_y[MAP_DIRECTIONS] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+
+static bool map_expect(FILE *file, char tag, const char *name);
 
 void map_create(map_t *map, int width, int height)
 {
@@ -37,180 +42,229 @@ void map_create(map_t *map, int width, int height)
 
     map->width  = width;
     map->height = height;
-}
-
-bool map_load(map_t *map, int what_load)
-{
-    int c;
-
-    int layer;
-
-    char token[21];
-
-    bool open_map_section = false;
-    bool map_section_found = false;
-
-    FILE *file;
-
-    if ((file = map_goto_section()) == NULL)
-        return false;
-
-    while ((c = fgetc(file)) != EOF) {
-        if (c == '<') {
-            fscanf(file, "%20s", token);
-
-            if (strcmp(token, "Map") == 0) {
-                open_map_section = true;
-                map_section_found = true;
-
-                if (what_load == MAP_LOAD_DIMENSIONS)
-                    fscanf(file, "%u %u", &map->width, &map->height);
-            } else if (open_map_section && strcmp(token, "Layer") == 0) {
-                fscanf(file, "%u", &layer);
+    map->seed   = 0;
 
-                // Discard the newline character preceded by layer declaration
-                fgetc(file);
+    map->generator = 0;
 
-                if ((what_load == MAP_LOAD_LAYER_0 && layer == 0)
-                        || (what_load == MAP_LOAD_LAYER_1 && layer == 1)) {
-                    map->tiles[layer] = malloc(sizeof(tile_t *) * map->height);
+    map->edits = NULL;
+    map->edits_count = map->edits_capacity = 0;
 
-                    for (int y = 0; y < map->height; y++) {
-                        map->tiles[layer][y] = malloc(sizeof(tile_t) * map->width);
-                        fread(map->tiles[layer][y], sizeof(tile_t), map->width, file);
-                    }
-                }
-            } else if (open_map_section) {
-                break;
-            }
-        } else if (c == '>') {
-            fscanf(file, "%20s", token);
-
-            if (strcmp(token, "Map") == 0) {
-                open_map_section = false;
-                break;
-            } else if (open_map_section && strcmp(token, "Layer") == 0) {
-                continue;
-            } else if (open_map_section) {
-                break;
-            }
-        }
-    }
-
-    if (open_map_section)
-        map_destroy(map);
-
-    fclose(file);
-    return map_section_found && !open_map_section;
+    map->changed = NULL;
+    map->changed_context = NULL;
 }
 
 void map_destroy(map_t *map)
 {
-    // Free the map data
+    // Free the map data, a map that failed to load can miss some layers
     for (int i = 0; i < MAP_MAX_LAYERS; i++) {
+        if (map->tiles[i] == NULL)
+            continue;
+
         for (int j = 0; j < map->height; j++)
             free(map->tiles[i][j]);
 
         free(map->tiles[i]);
+        map->tiles[i] = NULL;
     }
 
+    free(map->edits);
+
     // Reset map state
     map->width  = 0;
     map->height = 0;
+
+    map->edits = NULL;
+    map->edits_count = map->edits_capacity = 0;
 }
 
-bool map_save(map_t *map)
+void map_write(map_t *map, FILE *file)
 {
-    FILE *file;
+    const long layers_size = (long) sizeof(tile_t) * MAP_MAX_LAYERS
+        * map->width * map->height;
 
-    if ((file = map_goto_section()) == NULL)
-        return false;
+    fprintf(file, "<Map %u %u %u\n", map->width, map->height, map->seed);
 
-    fprintf(file, "<Map %u %u\n", map->width, map->height);
-    for (int layer = 0; layer < MAP_MAX_LAYERS; layer++) {
-        fprintf(file, "<Layer %u\n", layer);
+    if (map->generator != 0
+            && (long) MAP_EDIT_SIZE * map->edits_count < layers_size) {
+        fprintf(file, "<Generator %u %u\n", map->generator,
+            map->edits_count);
+
+        for (unsigned i = 0; i < map->edits_count; i++) {
+            fwrite(&map->edits[i].layer, sizeof(int), 1, file);
+            fwrite(&map->edits[i].x, sizeof(int), 1, file);
+            fwrite(&map->edits[i].y, sizeof(int), 1, file);
+            fwrite(&map->edits[i].tile, sizeof(tile_t), 1, file);
+        }
+
+        fprintf(file, "\n>Generator\n");
+    } else {
+        for (int layer = 0; layer < MAP_MAX_LAYERS; layer++) {
+            fprintf(file, "<Layer %u\n", layer);
 
-        for (int y = 0; y < map->height; y++)
-            fwrite(map->tiles[layer][y], sizeof(tile_t), map->width, file);
+            for (int y = 0; y < map->height; y++)
+                fwrite(map->tiles[layer][y], sizeof(tile_t), map->width, file);
 
-        fprintf(file, "\n>Layer\n");
+            fprintf(file, "\n>Layer\n");
+        }
     }
 
     fprintf(file, ">Map\n");
-    fclose(file);
-
-    return true;
 }
 
-bool map_exists(void)
+bool map_read(map_t *map, FILE *file, int what_load)
 {
-    int c;
+    int width, height, layer;
+    unsigned seed = map->seed;
+    unsigned generator, count;
 
     char token[21];
+    map_edit_t edit;
 
-    bool open_map_section = false;
-    bool map_section_found = false;
-
-    FILE *file;
+    if (!map_expect(file, '<', "Map")
+            || fscanf(file, "%d %d", &width, &height) != 2)
+        return false;
 
-    if ((file = game_file("r")) == NULL)
+    // The saves before the seed have the newline here, they keep the seed
+    // that the map has.
+    if (fgetc(file) == ' ' && (fscanf(file, "%u", &seed) != 1
+                || fgetc(file) != '\n'))
         return false;
 
-    while ((c = fgetc(file)) != EOF) {
-        if (c == '<') {
-            fscanf(file, "%20s", token);
+    if (what_load == MAP_LOAD_DIMENSIONS) {
+        map->width = width;
+        map->height = height;
+        map->seed = seed;
+
+        map->generator = 0;
+
+        map->edits = NULL;
+        map->edits_count = map->edits_capacity = 0;
+
+        map->changed = NULL;
+        map->changed_context = NULL;
+    }
 
-            if (strcmp(token, "Map") == 0) {
-                open_map_section = true;
-                map_section_found = true;
+    for (;;) {
+        if (fscanf(file, " %20s", token) != 1)
+            return false;
+
+        if (strcmp(token, ">Map") == 0) {
+            fgetc(file);
+            return true;
+        } else if (strcmp(token, "<Layer") == 0) {
+            if (fscanf(file, "%d", &layer) != 1 || fgetc(file) != '\n')
+                return false;
+
+            // Discard the layers that aren't loaded without reading them
+            if ((what_load == MAP_LOAD_LAYER_0 && layer == 0)
+                    || (what_load == MAP_LOAD_LAYER_1 && layer == 1)) {
+                map->tiles[layer] = malloc(sizeof(tile_t *) * height);
+
+                for (int y = 0; y < height; y++) {
+                    map->tiles[layer][y] = malloc(sizeof(tile_t) * width);
+                    fread(map->tiles[layer][y], sizeof(tile_t), width, file);
+                }
+            } else {
+                fseek(file, (long) sizeof(tile_t) * width * height, SEEK_CUR);
             }
-        } else if (c == '>') {
-            fscanf(file, "%20s", token);
 
-            if (strcmp(token, "Map") == 0) {
-                open_map_section = false;
-                break;
+            if (!map_expect(file, '>', "Layer"))
+                return false;
+        } else if (strcmp(token, "<Generator") == 0) {
+            if (fscanf(file, "%u %u", &generator, &count) != 2
+                    || fgetc(file) != '\n')
+                return false;
+
+            if (what_load == MAP_LOAD_DIMENSIONS)
+                map->generator = generator;
+
+            if (what_load == MAP_LOAD_LAYER_1) {
+                for (unsigned i = 0; i < count; i++) {
+                    fread(&edit.layer, sizeof(int), 1, file);
+                    fread(&edit.x, sizeof(int), 1, file);
+                    fread(&edit.y, sizeof(int), 1, file);
+                    fread(&edit.tile, sizeof(tile_t), 1, file);
+
+                    if (edit.layer < 0 || edit.layer >= MAP_MAX_LAYERS
+                            || edit.x < 0 || edit.x >= width
+                            || edit.y < 0 || edit.y >= height)
+                        return false;
+
+                    map_set_tile(map, edit.layer, edit.x, edit.y, edit.tile);
+                }
+            } else {
+                fseek(file, (long) MAP_EDIT_SIZE * count, SEEK_CUR);
             }
+
+            if (!map_expect(file, '>', "Generator"))
+                return false;
+        } else {
+            return false;
         }
     }
+}
 
-    fclose(file);
-    return map_section_found && !open_map_section;
+tile_t map_tile(map_t *map, int layer, int x, int y)
+{
+    return map->tiles[layer][y][x];
 }
 
-static FILE *map_goto_section(void)
+bool map_collides(const map_t *map, int x, int y)
 {
-    int c;
+    if (x < 0 || x >= map->width || y < 0 || y >= map->height)
+        return true;
 
-    char token[21];
+    for (int layer = 0; layer < MAP_MAX_LAYERS; layer++)
+        if (tile_collision(map->tiles[layer][y][x]))
+            return true;
 
-    fpos_t pos;
+    return false;
+}
 
-    FILE *file;
+void map_set_tile(map_t *map, int layer, int x, int y, tile_t tile)
+{
+    unsigned i;
 
-    if ((file = game_file("r+")) == NULL)
-        return (file = game_file("w"));
+    map->tiles[layer][y][x] = tile;
 
-    fgetpos(file, &pos);
-    while ((c = fgetc(file)) != EOF) {
-        if (c == '<') {
-            fscanf(file, "%20s", token);
+    if (map->changed != NULL)
+        map->changed(map->changed_context, x, y);
 
-            if (strcmp(token, "Map") == 0) {
-                fsetpos(file, &pos);
-                return file;
-            }
+    // The maps that aren't from the generator are saved with all the tiles
+    if (map->generator == 0)
+        return;
+
+    for (i = 0; i < map->edits_count; i++) {
+        if (map->edits[i].layer == layer && map->edits[i].x == x
+                && map->edits[i].y == y)
+            break;
+    }
+
+    if (i == map->edits_count) {
+        if (map->edits_count + 1 > map->edits_capacity) {
+            map->edits_capacity = map->edits_capacity == 0
+                ? 32 : map->edits_capacity * 2;
+
+            map->edits = realloc(map->edits,
+                sizeof(map_edit_t) * map->edits_capacity);
         }
 
-        fgetpos(file, &pos);
+        map->edits_count++;
     }
 
-    fclose(file);
-    return (file = game_file("a"));
+    map->edits[i] = (map_edit_t) { layer, x, y, tile };
 }
 
-tile_t map_tile(map_t *map, int layer, int x, int y)
+void map_watch(map_t *map, map_changed_t changed, void *context)
 {
-    return map->tiles[layer][y][x];
+    map->changed = changed;
+    map->changed_context = context;
 }
 
+static bool map_expect(FILE *file, char tag, const char *name)
+{
+    char token[21];
+
+    return fscanf(file, " %20s", token) == 1 && token[0] == tag
+        && strcmp(token + 1, name) == 0;
+}
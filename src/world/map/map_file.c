@@ -0,0 +1,167 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "game.h"
+#include "utils/stats.h"
+#include "world/map/map.h"
+#include "world/map/worldgen.h"
+
+static bool map_find_section(FILE *file, long *start, long *end);
+
+bool map_load(map_t *map, int what_load)
+{
+    bool loaded;
+    long start, end;
+
+    FILE *file;
+
+    if ((file = game_file("r")) == NULL)
+        return false;
+
+    if (!map_find_section(file, &start, &end)) {
+        fclose(file);
+        return false;
+    }
+
+    // The saves before the seed keep the current one
+    if (what_load == MAP_LOAD_DIMENSIONS)
+        map->seed = game_seed();
+
+    // The time to read the layers against the one to make them again
+    stats_begin("map read");
+    fseek(file, start, SEEK_SET);
+    loaded = map_read(map, file, what_load);
+    fclose(file);
+    stats_end("map read");
+
+    if (loaded && what_load == MAP_LOAD_LAYER_0 && map->generator != 0) {
+        stats_begin("map terrain");
+        loaded = worldgen_terrain(map, game_workers());
+        stats_end("map terrain");
+    }
+
+    return loaded;
+}
+
+bool map_save(map_t *map)
+{
+    char *head = NULL, *tail = NULL;
+    long start = 0, end = 0, size = 0;
+
+    FILE *file;
+
+    // The map section changes of size with the tiles changed, the sections
+    // around it are kept and the whole save is written again, on a new file
+    // that only replaces it once complete.
+    if ((file = game_file("r")) != NULL) {
+        fseek(file, 0, SEEK_END);
+        size = ftell(file);
+
+        if (!map_find_section(file, &start, &end))
+            start = end = size;
+
+        head = malloc(start + 1);
+        tail = malloc(size - end + 1);
+
+        fseek(file, 0, SEEK_SET);
+        fread(head, 1, start, file);
+
+        fseek(file, end, SEEK_SET);
+        fread(tail, 1, size - end, file);
+
+        fclose(file);
+    }
+
+    if ((file = game_file_replace()) == NULL) {
+        free(head);
+        free(tail);
+        return false;
+    }
+
+    fwrite(head, 1, start, file);
+    map_write(map, file);
+    fwrite(tail, 1, size - end, file);
+
+    free(head);
+    free(tail);
+
+    return game_file_commit(file);
+}
+
+bool map_exists(void)
+{
+    map_t map = { 0 };
+    long start, end;
+
+    bool exists;
+
+    FILE *file;
+
+    if ((file = game_file("r")) == NULL)
+        return false;
+
+    // A map from other version of the generator can't be made again
+    exists = map_find_section(file, &start, &end);
+    if (exists) {
+        fseek(file, start, SEEK_SET);
+        exists = map_read(&map, file, MAP_LOAD_DIMENSIONS)
+            && (map.generator == 0 || map.generator == WORLDGEN_VERSION);
+    }
+
+    fclose(file);
+    return exists;
+}
+
+// Find where the map section starts and where the next one does, false when
+// there's no complete map section.
+static bool map_find_section(FILE *file, long *start, long *end)
+{
+    int c;
+
+    char token[21];
+
+    map_t map = { 0 };
+
+    fseek(file, 0, SEEK_SET);
+
+    *start = ftell(file);
+    while ((c = fgetc(file)) != EOF) {
+        if (c == '<') {
+            fscanf(file, "%20s", token);
+
+            if (strcmp(token, "Map") == 0) {
+                fseek(file, *start, SEEK_SET);
+
+                if (!map_read(&map, file, MAP_LOAD_DIMENSIONS))
+                    return false;
+
+                *end = ftell(file);
+                return true;
+            }
+        }
+
+        *start = ftell(file);
+    }
+
+    return false;
+}
@@ -0,0 +1,171 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "utils/workers.h"
+#include "world/map/map.h"
+#include "world/map/raycast.h"
+#include "world/map/tile.h"
+
+typedef struct {
+    raycast_batch_t *batch;
+    map_t           *map;
+} raycast_job_t;
+
+static void raycast_range(void *job, unsigned worker, unsigned first,
+    unsigned last);
+
+bool raycast(map_t *map, float x, float y, float dx, float dy, float length,
+    raycast_hit_t *hit)
+{
+    const float norm = sqrtf(dx * dx + dy * dy);
+
+    int tile_x = floorf(x);
+    int tile_y = floorf(y);
+    int step_x, step_y;
+
+    // Length of the ray to cross a whole tile on each axis, and to cross the
+    // next border of each axis.
+    float delta_x, delta_y;
+    float next_x, next_y;
+    float walked = 0;
+
+    if (norm > 0) {
+        dx /= norm;
+        dy /= norm;
+    }
+
+    step_x = dx < 0 ? -1 : 1;
+    step_y = dy < 0 ? -1 : 1;
+
+    delta_x = dx != 0 ? fabsf(1 / dx) : INFINITY;
+    delta_y = dy != 0 ? fabsf(1 / dy) : INFINITY;
+
+    next_x = dx == 0 ? INFINITY
+        : (dx < 0 ? x - tile_x : tile_x + 1 - x) * delta_x;
+    next_y = dy == 0 ? INFINITY
+        : (dy < 0 ? y - tile_y : tile_y + 1 - y) * delta_y;
+
+    for (;;) {
+        if (map_collides(map, tile_x, tile_y)) {
+            *hit = (raycast_hit_t) { true, tile_x, tile_y, walked };
+            return true;
+        }
+
+        if (next_x < next_y) {
+            walked = next_x;
+            next_x += delta_x;
+            tile_x += step_x;
+        } else {
+            walked = next_y;
+            next_y += delta_y;
+            tile_y += step_y;
+        }
+
+        // The tile entered at the end of the ray is past it, and the rays
+        // without direction also end here, they never walk.
+        if (walked >= length)
+            break;
+    }
+
+    *hit = (raycast_hit_t) {
+        false, floorf(x + dx * length), floorf(y + dy * length), length
+    };
+
+    return false;
+}
+
+bool raycast_visible(map_t *map, float x0, float y0, float x1, float y1)
+{
+    raycast_hit_t hit;
+
+    return !raycast(map, x0, y0, x1 - x0, y1 - y0,
+        sqrtf((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0)), &hit);
+}
+
+void raycast_batch_create(raycast_batch_t *batch)
+{
+    batch->count = 0;
+    batch->capacity = 0;
+
+    batch->x = batch->y = NULL;
+    batch->dx = batch->dy = NULL;
+    batch->length = NULL;
+    batch->hits = NULL;
+}
+
+void raycast_batch_destroy(raycast_batch_t *batch)
+{
+    free(batch->x);
+    free(batch->y);
+    free(batch->dx);
+    free(batch->dy);
+    free(batch->length);
+    free(batch->hits);
+
+    raycast_batch_create(batch);
+}
+
+void raycast_batch_add(raycast_batch_t *batch, float x, float y, float dx,
+    float dy, float length)
+{
+    if (batch->count + 1 > batch->capacity) {
+        batch->capacity = batch->capacity == 0 ? 32 : batch->capacity * 2;
+
+        batch->x = realloc(batch->x, sizeof(float) * batch->capacity);
+        batch->y = realloc(batch->y, sizeof(float) * batch->capacity);
+        batch->dx = realloc(batch->dx, sizeof(float) * batch->capacity);
+        batch->dy = realloc(batch->dy, sizeof(float) * batch->capacity);
+        batch->length = realloc(batch->length,
+            sizeof(float) * batch->capacity);
+        batch->hits = realloc(batch->hits,
+            sizeof(raycast_hit_t) * batch->capacity);
+    }
+
+    batch->x[batch->count] = x;
+    batch->y[batch->count] = y;
+    batch->dx[batch->count] = dx;
+    batch->dy[batch->count] = dy;
+    batch->length[batch->count] = length;
+
+    batch->count++;
+}
+
+void raycast_batch_cast(raycast_batch_t *batch, map_t *map,
+    workers_t *workers)
+{
+    raycast_job_t job = { batch, map };
+
+    workers_run(workers, batch->count, raycast_range, &job);
+}
+
+static void raycast_range(void *job, unsigned worker, unsigned first,
+    unsigned last)
+{
+    raycast_batch_t *batch = ((raycast_job_t *) job)->batch;
+    map_t *map = ((raycast_job_t *) job)->map;
+
+    (void) worker;
+
+    for (unsigned i = first; i < last; i++)
+        raycast(map, batch->x[i], batch->y[i], batch->dx[i], batch->dy[i],
+            batch->length[i], &batch->hits[i]);
+}
@@ -0,0 +1,261 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include "utils/utils.h"
+#include "utils/workers.h"
+#include "world/map/map.h"
+#include "world/map/regions.h"
+#include "world/map/tile.h"
+
+// Each worker labels its rows alone, the labels of each worker follow the ones
+// of the workers above it, and they are joined on the rows between the workers
+// before they are numbered as regions.
+typedef struct {
+    regions_t *regions;
+    map_t     *map;
+
+    // Row of the map of the first row of the regions
+    int first;
+
+    // Rows, number of labels and tiles of each label of each worker
+    struct {
+        unsigned first;
+        unsigned last;
+
+        unsigned  count;
+        unsigned  base;
+        unsigned *sizes;
+        unsigned  capacity;
+    } *workers;
+
+    // Region of each label, after they are joined
+    int *joined;
+} regions_job_t;
+
+static void regions_label(void *job, unsigned worker, unsigned first,
+    unsigned last);
+static void regions_number(void *job, unsigned worker, unsigned first,
+    unsigned last);
+
+void regions_create(regions_t *regions, map_t *map, int first, int last,
+    workers_t *workers)
+{
+    const unsigned count = workers_count(workers);
+
+    regions_job_t job = { .regions = regions, .map = map, .first = first };
+    unsigned labels = 0;
+    int *parent, *above, *below;
+    int previous = -1;
+
+    regions->width = map->width;
+    regions->height = last - first;
+    regions->count = 0;
+
+    regions->ids = malloc(sizeof(int) * regions->width * regions->height);
+
+    job.workers = calloc(count, sizeof(*job.workers));
+    workers_run(workers, regions->height, regions_label, &job);
+
+    for (unsigned worker = 0; worker < count; worker++) {
+        job.workers[worker].base = labels;
+        labels += job.workers[worker].count;
+    }
+
+    parent = malloc(sizeof(int) * max(labels, 1));
+    for (unsigned label = 0; label < labels; label++)
+        parent[label] = label;
+
+    // Join the labels that touch on the first row of each worker and on the
+    // last row of the one above, the workers without rows are skipped.
+    for (unsigned worker = 0; worker < count; worker++) {
+        if (job.workers[worker].first == job.workers[worker].last)
+            continue;
+
+        if (previous >= 0) {
+            below = regions->ids + job.workers[worker].first * regions->width;
+            above = below - regions->width;
+
+            for (int x = 0; x < regions->width; x++) {
+                if (above[x] != REGIONS_NONE && below[x] != REGIONS_NONE)
+                    regions_union(parent,
+                        job.workers[previous].base + above[x],
+                        job.workers[worker].base + below[x]);
+            }
+        }
+
+        previous = worker;
+    }
+
+    // The root of each label is the first label of its region, so it's
+    // numbered before the others.
+    job.joined = malloc(sizeof(int) * max(labels, 1));
+    regions->sizes = malloc(sizeof(unsigned) * max(labels, 1));
+
+    for (unsigned label = 0; label < labels; label++) {
+        int root = regions_find(parent, label);
+
+        if (root == (int) label) {
+            regions->sizes[regions->count] = 0;
+            job.joined[label] = regions->count++;
+        } else {
+            job.joined[label] = job.joined[root];
+        }
+    }
+
+    for (unsigned worker = 0; worker < count; worker++) {
+        for (unsigned label = 0; label < job.workers[worker].count; label++)
+            regions->sizes[job.joined[job.workers[worker].base + label]] +=
+                job.workers[worker].sizes[label];
+
+        free(job.workers[worker].sizes);
+    }
+
+    workers_run(workers, regions->height, regions_number, &job);
+
+    free(job.joined);
+    free(job.workers);
+    free(parent);
+}
+
+void regions_destroy(regions_t *regions)
+{
+    free(regions->ids);
+    free(regions->sizes);
+
+    regions->ids = NULL;
+    regions->sizes = NULL;
+    regions->count = 0;
+}
+
+int regions_largest(regions_t *regions)
+{
+    int largest = REGIONS_NONE;
+
+    for (unsigned region = 0; region < regions->count; region++) {
+        if (largest == REGIONS_NONE
+                || regions->sizes[region] > regions->sizes[largest])
+            largest = region;
+    }
+
+    return largest;
+}
+
+int regions_find(int *parent, int label)
+{
+    // Path halving, each label on the way skips its parent
+    while (parent[label] != label) {
+        parent[label] = parent[parent[label]];
+        label = parent[label];
+    }
+
+    return label;
+}
+
+void regions_union(int *parent, int a, int b)
+{
+    a = regions_find(parent, a);
+    b = regions_find(parent, b);
+
+    if (a < b)
+        parent[b] = a;
+    else if (b < a)
+        parent[a] = b;
+}
+
+static void regions_label(void *job_pointer, unsigned worker, unsigned first,
+    unsigned last)
+{
+    regions_job_t *job = job_pointer;
+    map_t *map = job->map;
+
+    const int width = job->regions->width;
+    int *ids = job->regions->ids;
+    int i, row;
+
+    unsigned *count = &job->workers[worker].count;
+    unsigned *capacity = &job->workers[worker].capacity;
+    unsigned **sizes = &job->workers[worker].sizes;
+
+    job->workers[worker].first = first;
+    job->workers[worker].last = last;
+
+    // Each tile starts as its own root, joined with the tiles on its left and
+    // above. The root of a set is its first tile, the parent of each tile is
+    // always before it.
+    for (int y = first; y < (int) last; y++) {
+        row = job->first + y;
+
+        for (int x = 0; x < width; x++) {
+            i = y * width + x;
+
+            if (map_collides(map, x, row)) {
+                ids[i] = REGIONS_NONE;
+                continue;
+            }
+
+            ids[i] = i;
+
+            if (x > 0 && ids[i - 1] != REGIONS_NONE)
+                regions_union(ids, i - 1, i);
+
+            if (y > (int) first && ids[i - width] != REGIONS_NONE)
+                regions_union(ids, i - width, i);
+        }
+    }
+
+    // The parent of a tile is already numbered when it's reached, the roots
+    // take the next label.
+    for (i = first * width; i < (int) last * width; i++) {
+        if (ids[i] == REGIONS_NONE)
+            continue;
+
+        if (ids[i] == i) {
+            if (*count + 1 > *capacity) {
+                *capacity = *capacity == 0 ? 32 : *capacity * 2;
+                *sizes = realloc(*sizes, sizeof(unsigned) * *capacity);
+            }
+
+            (*sizes)[*count] = 0;
+            ids[i] = (*count)++;
+        } else {
+            ids[i] = ids[ids[i]];
+        }
+
+        (*sizes)[ids[i]]++;
+    }
+}
+
+static void regions_number(void *job_pointer, unsigned worker, unsigned first,
+    unsigned last)
+{
+    regions_job_t *job = job_pointer;
+
+    const int width = job->regions->width;
+    const unsigned base = job->workers[worker].base;
+
+    int *ids = job->regions->ids;
+
+    for (int i = first * width; i < (int) last * width; i++) {
+        if (ids[i] != REGIONS_NONE)
+            ids[i] = job->joined[base + ids[i]];
+    }
+}
@@ -0,0 +1,1442 @@
+/*
+The GPLv3 License (GPLv3)
+
+Copyright (c) 2022 Jonatha Gabriel <jonathagabrielns@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "raylib.h"
+#include "utils/poisson.h"
+#include "utils/random.h"
+#include "utils/stats.h"
+#include "utils/utils.h"
+#include "utils/workers.h"
+#include "world/map/map.h"
+#include "world/map/tile.h"
+#include "world/map/worldgen.h"
+#include "world/entity/player.h"
+#include "world/entity/spawner.h"
+
+#define WORLDGEN_MAP_LAND_SPAWN_RATE    (55.0 / 100.0)
+#define WORLDGEN_TREE_GENERATION_FACTOR (5.0 / 100.0)
+#define WORLDGEN_TREE_DISTANCE          2.5
+
+#define WORLDGEN_FLOWER_SPAWN_RATE      (8.0 / 100.0)
+#define WORLDGEN_SINGLE_ROCK_SPAWN_RATE (0.5 / 100.0)
+#define WORLDGEN_ROCKS_SPAWN_RATE       (40.0 / 100.0)
+#define WORLDGEN_GRAVESTONE_SPAWN_RATE  (20.0 / 100.0)
+
+#define worldgen_bands(rows) \
+    (((rows) + WORLDGEN_BAND_ROWS - 1) / WORLDGEN_BAND_ROWS)
+
+enum {
+    WORLDGEN_ABOVE_TREES,
+    WORLDGEN_ABOVE_SPAWNERS,
+};
+
+enum {
+    WORLDGEN_STEPS_STAGE0 = 1,
+    WORLDGEN_STEPS_STAGE1 = 10,
+    WORLDGEN_STEPS_STAGE2 = 5,
+    WORLDGEN_STEPS_STAGE3 = 5,
+    WORLDGEN_STEPS_STAGE5 = 1,
+    WORLDGEN_STEPS_STAGE7 = 1,
+};
+
+// Rows around a band that the streaming generator makes with it, the stage 1
+// and the stage 3 look at one row above and below on each step.
+#define WORLDGEN_HALO (WORLDGEN_STEPS_STAGE1 + 1 + WORLDGEN_STEPS_STAGE3)
+
+// The stages that are run by the workers split the map in bands of contiguous
+// rows, the rows around a band (its halo) are read from a buffer that isn't
+// written by the same job so the order that the bands finish doesn't matter.
+typedef struct {
+    worldgen_t *world;
+
+    map_t   *next;
+    tile_t **layer;
+
+    random_t random;
+    uint64_t seed;
+} worldgen_job_t;
+
+// Regions of the bands of the streaming generator, the labels of each band
+// follow the ones of the bands above and are joined with them. The root of
+// each region is its first label, the same region that the stage 5 numbers
+// first.
+typedef struct {
+    int      *parent;
+    unsigned *sizes;
+
+    // First tile of each label
+    Vector2 *firsts;
+
+    unsigned count;
+    unsigned capacity;
+
+    // Label of each tile of the last row of the band above
+    int *above;
+} worldgen_labels_t;
+
+// The water tiles are chosen by the land around them, the bits of the mask are
+// the 8 neighbors from the top left to the bottom right. A rule matches when
+// the neighbors have all the bits of must have and no bit out of can have, the
+// last rule that matches is the one used.
+static const struct {
+    uint8_t must_have;
+    uint8_t can_have;
+    tile_t  tile;
+} g_autotile_rules[] = {
+    // Sides
+    { 0x02, 0x07, tile_new(9, 0) },
+    { 0x10, 0x94, tile_new(10, 1) },
+    { 0x40, 0xE0, tile_new(9, 2) },
+    { 0x08, 0x29, tile_new(8, 1) },
+
+    // Sides double
+    { 0x42, 0xE7, tile_new(4, 4) },
+    { 0x18, 0xBD, tile_new(5, 4) },
+
+    // Sides all
+    { 0x59, 0xFF, tile_new(6, 4) },
+
+    // Sides triple
+    { 0x1A, 0xBF, tile_new(6, 0) },
+    { 0x58, 0xFD, tile_new(7, 0) },
+    { 0x4A, 0xEF, tile_new(6, 1) },
+    { 0x52, 0xF7, tile_new(7, 1) },
+
+    // Sides corner
+    { 0x22, 0x27, tile_new(0, 1) },
+    { 0x82, 0x87, tile_new(1, 1) },
+    { 0x41, 0xE1, tile_new(0, 0) },
+    { 0x44, 0xE4, tile_new(1, 0) },
+
+    { 0x0C, 0x2D, tile_new(3, 1) },
+    { 0x88, 0xA9, tile_new(3, 0) },
+    { 0x11, 0x95, tile_new(2, 1) },
+    { 0x30, 0xB4, tile_new(2, 0) },
+
+    // Sides double corner
+    { 0xA2, 0xA7, tile_new(5, 3) },
+    { 0x31, 0xB5, tile_new(4, 2) },
+    { 0x45, 0xE5, tile_new(4, 3) },
+    { 0x8C, 0xAD, tile_new(5, 2) },
+
+    // Diagonals
+    { 0x0A, 0x2F, tile_new(8, 0) },
+    { 0x12, 0x97, tile_new(10, 0) },
+    { 0x50, 0xF4, tile_new(10, 2) },
+    { 0x48, 0xE9, tile_new(8, 2) },
+
+    // Diagonals corner
+    { 0x8A, 0xAF, tile_new(6, 2) },
+    { 0x32, 0xB7, tile_new(7, 2) },
+    { 0x51, 0xF5, tile_new(7, 3) },
+    { 0x4C, 0xED, tile_new(6, 3) },
+
+    // Corners
+    { 0x80, 0x80, tile_new(8, 3) },
+    { 0x20, 0x20, tile_new(9, 3) },
+    { 0x04, 0x04, tile_new(8, 4) },
+    { 0x01, 0x01, tile_new(9, 4) },
+
+    // Corners double
+    { 0x84, 0x84, tile_new(3, 3) },
+    { 0x21, 0x21, tile_new(2, 3) },
+    { 0x05, 0x05, tile_new(3, 4) },
+    { 0xA0, 0xA0, tile_new(2, 4) },
+
+    // Corners opposite double
+    { 0x81, 0x81, tile_new(3, 2) },
+    { 0x24, 0x24, tile_new(2, 2) },
+
+    // Corners triple
+    { 0x85, 0x85, tile_new(5, 0) },
+    { 0x25, 0x25, tile_new(4, 0) },
+    { 0xA4, 0xA4, tile_new(5, 1) },
+    { 0xA1, 0xA1, tile_new(4, 1) },
+
+    // Corners all
+    { 0xA5, 0xA5, tile_new(7, 4) },
+};
+
+static struct {
+    // Tile of each neighbors mask, built from the rules by the first world
+    // that reaches the stage 2, whatever the thread it's on.
+    tile_t         autotile[256];
+    pthread_once_t autotile_once;
+} g_worldgen = {
+    .autotile_once = PTHREAD_ONCE_INIT,
+};
+
+static void worldgen_create_rows(worldgen_t *world, int width, int height,
+    unsigned seed, workers_t *workers, int first, int last);
+static void worldgen_write_player(FILE *file, Vector2 position);
+static void worldgen_write_spawners(FILE *file, const Vector2 *spawners,
+    unsigned count);
+static void worldgen_changed(worldgen_t *world, int first_row, int last_row);
+
+static void worldgen_stage0(worldgen_t *world);
+static void worldgen_stage1(worldgen_t *world);
+static void worldgen_stage2(worldgen_t *world);
+static void worldgen_stage3(worldgen_t *world);
+static void worldgen_stage4(worldgen_t *world);
+static void worldgen_stage5(worldgen_t *world);
+static void worldgen_stage6(worldgen_t *world);
+static void worldgen_stage7(worldgen_t *world);
+
+// Helper functions
+static void stage0_rows(void *job, unsigned worker, unsigned first,
+    unsigned last);
+static void stage1_pack(void *job, unsigned worker, unsigned first,
+    unsigned last);
+static void stage1_unpack(void *job, unsigned worker, unsigned first,
+    unsigned last);
+static void stage1_step(void *job, unsigned worker, unsigned first,
+    unsigned last);
+static void stage2_rows(void *job, unsigned worker, unsigned first,
+    unsigned last);
+static void stage2_build_autotile(void);
+static int stage2_find_neighbors(map_t *map, int x, int y);
+static void stage3_copy(void *job, unsigned worker, unsigned first,
+    unsigned last);
+static void stage3_rows(void *job, unsigned worker, unsigned first,
+    unsigned last);
+static int stage3_count_neighbors(map_t *map, tile_t **layer, int x, int y,
+    tile_t tile);
+static void worldgen_trees(worldgen_t *world, int band);
+static void worldgen_spawners(worldgen_t *world, int band);
+static void stage4_place_tree(worldgen_t *world, random_t *random);
+static void stage6_place_spawner(worldgen_t *world, random_t *random);
+static void stage6_reachable(worldgen_t *world, unsigned first);
+static void worldgen_sample(worldgen_t *world, random_t *random, bool *mask,
+    int first, int rows, float radius, int above);
+static uint64_t worldgen_seed(random_t *random);
+static int worldgen_join(worldgen_labels_t *labels, regions_t *regions,
+    int first);
+static int worldgen_largest(worldgen_labels_t *labels);
+
+void worldgen_create(worldgen_t *world, int width, int height, unsigned seed,
+    workers_t *workers)
+{
+    worldgen_create_rows(world, width, height, seed, workers, 0, height);
+}
+
+void worldgen_destroy(worldgen_t *world)
+{
+    map_destroy(&world->map);
+    regions_destroy(&world->regions);
+
+    free(world->spawners);
+    free(world->samples);
+
+    for (int above = 0; above < 2; above++)
+        free(world->above[above].samples);
+
+    free(world->bitboard.current);
+    free(world->bitboard.next);
+}
+
+bool worldgen_step(worldgen_t *world)
+{
+    double start = stats_now();
+
+    if (world->stage >= WORLDGEN_STAGES)
+        return false;
+
+    world->changed_first = world->map.height;
+    world->changed_last = 0;
+
+    switch (world->stage) {
+    case 0:
+        worldgen_stage0(world);
+        break;
+    case 1:
+        worldgen_stage1(world);
+        break;
+    case 2:
+        worldgen_stage2(world);
+        break;
+    case 3:
+        worldgen_stage3(world);
+        break;
+    case 4:
+        worldgen_stage4(world);
+        break;
+    case 5:
+        worldgen_stage5(world);
+        break;
+    case 6:
+        worldgen_stage6(world);
+        break;
+    case 7:
+        worldgen_stage7(world);
+        break;
+    }
+
+    world->times[world->stage] += stats_now() - start;
+
+    if (world->total < world->steps)
+        world->total = world->steps;
+
+    world->progress = world->stage * 100 + 100
+        * (world->total - world->steps + 1) / world->total;
+
+    if (--world->steps == 0) {
+        world->stage++;
+        world->total = 0;
+    }
+
+    return world->stage < WORLDGEN_STAGES;
+}
+
+void worldgen_run(worldgen_t *world)
+{
+    while (worldgen_step(world))
+        continue;
+}
+
+const char *worldgen_stage_name(int stage)
+{
+    static const char *names[WORLDGEN_STAGES] = {
+        "land", "smoothing", "water", "decorations", "trees", "regions",
+        "spawners", "player",
+    };
+
+    return stage >= 0 && stage < WORLDGEN_STAGES ? names[stage] : "done";
+}
+
+void worldgen_save(worldgen_t *world, FILE *file)
+{
+    map_write(&world->map, file);
+
+    worldgen_write_player(file, world->player);
+
+    fprintf(file, "<Spawners\n");
+    worldgen_write_spawners(file, world->spawners, world->spawners_count);
+    fprintf(file, ">Spawners\n");
+}
+
+bool worldgen_terrain(map_t *map, workers_t *workers)
+{
+    worldgen_t world;
+
+    if (map->generator != WORLDGEN_VERSION)
+        return false;
+
+    worldgen_create(&world, map->width, map->height, map->seed, workers);
+
+    // The layers are done with the trees, the spawners and the player are on
+    // their own sections.
+    while (world.stage < 5)
+        worldgen_step(&world);
+
+    // The rows now belong to the map
+    for (int layer = 0; layer < MAP_MAX_LAYERS; layer++) {
+        map->tiles[layer] = world.map.tiles[layer];
+        world.map.tiles[layer] = NULL;
+    }
+
+    world.map.height = 0;
+    worldgen_destroy(&world);
+
+    return true;
+}
+
+unsigned worldgen_stream(worldgen_t *world, int width, int height,
+    unsigned seed, workers_t *workers, FILE *file)
+{
+    const int bands = worldgen_bands(height);
+    const long layer_size = (long) sizeof(tile_t) * width * height;
+
+    // The player walks to the top left from here until it's on the largest
+    // region, as on the stage 7.
+    const int center_x = width / 2 - 1;
+    const int center_y = height / 2 - 1;
+
+    worldgen_t region;
+    tile_t *rows[WORLDGEN_BAND_ROWS];
+
+    long layers[MAP_MAX_LAYERS];
+    long player, spawners;
+
+    // The regions are only known when all the bands are done, the spawners and
+    // the tiles of the walk of the player keep their labels until then.
+    worldgen_labels_t labels = { 0 };
+    regions_t regions;
+    int *spawners_labels = NULL;
+    struct {
+        Vector2 *tiles;
+        int     *labels;
+        unsigned count;
+    } walk = { 0 };
+
+    int first, last, top, x, base, largest;
+    unsigned kept;
+    double start;
+
+    // The band being placed and the one above it, that's only done after the
+    // tops of the trees of the other are on its last row.
+    worldgen_create_rows(world, width, height, seed, workers, 0,
+        min(2 * WORLDGEN_BAND_ROWS, height));
+
+    labels.above = malloc(sizeof(int) * width);
+    for (x = 0; x < width; x++)
+        labels.above[x] = REGIONS_NONE;
+
+    walk.tiles = malloc(sizeof(Vector2) * max(min(width, height), 1));
+    walk.labels = malloc(sizeof(int) * max(min(width, height), 1));
+
+    // The sections are where worldgen_save() writes them, the rows of each
+    // layer are written as their bands are done.
+    fprintf(file, "<Map %u %u %u\n", width, height, seed);
+    for (int layer = 0; layer < MAP_MAX_LAYERS; layer++) {
+        fprintf(file, "<Layer %u\n", layer);
+
+        layers[layer] = ftell(file);
+        fseek(file, layers[layer] + layer_size, SEEK_SET);
+
+        fprintf(file, "\n>Layer\n");
+    }
+
+    fprintf(file, ">Map\n");
+
+    player = ftell(file);
+    worldgen_write_player(file, world->player);
+
+    fprintf(file, "<Spawners\n");
+    spawners = ftell(file);
+
+    for (int band = 0; band <= bands; band++) {
+        if (band < bands) {
+            first = band * WORLDGEN_BAND_ROWS;
+            last = min(first + WORLDGEN_BAND_ROWS, height);
+
+            // The band above of the last one is already on the file
+            if (band >= 2) {
+                for (int layer = 0; layer < MAP_MAX_LAYERS; layer++) {
+                    memcpy(rows, world->map.tiles[layer], sizeof(rows));
+                    memmove(world->map.tiles[layer],
+                        world->map.tiles[layer] + WORLDGEN_BAND_ROWS,
+                        sizeof(rows));
+                    memcpy(world->map.tiles[layer] + WORLDGEN_BAND_ROWS, rows,
+                        sizeof(rows));
+                }
+
+                world->origin += WORLDGEN_BAND_ROWS;
+            }
+
+            // The stages before the trees only look at the rows around, they
+            // run on the band with its halo and keep only the band.
+            worldgen_create_rows(&region, width, height, seed, workers,
+                max(first - WORLDGEN_HALO, 0), min(last + WORLDGEN_HALO,
+                    height));
+
+            while (region.stage < 4)
+                worldgen_step(&region);
+
+            for (int stage = 0; stage < 4; stage++)
+                world->times[stage] += region.times[stage];
+
+            for (int layer = 0; layer < MAP_MAX_LAYERS; layer++)
+                for (int y = first; y < last; y++)
+                    memcpy(world->map.tiles[layer][y - world->origin],
+                        region.map.tiles[layer][y - region.origin],
+                        sizeof(tile_t) * width);
+
+            // The stream is on the same state for all the bands
+            if (band == 0) {
+                world->trees_seed = worldgen_seed(&region.random);
+                world->spawners_seed = worldgen_seed(&region.random);
+            }
+
+            worldgen_destroy(&region);
+
+            start = stats_now();
+            worldgen_trees(world, band);
+            world->times[4] += stats_now() - start;
+        }
+
+        if (band == 0)
+            continue;
+
+        first = (band - 1) * WORLDGEN_BAND_ROWS;
+        last = min(first + WORLDGEN_BAND_ROWS, height);
+        top = first - world->origin;
+
+        start = stats_now();
+        regions_create(&regions, &world->map, top, top + last - first,
+            workers);
+        base = worldgen_join(&labels, &regions, first);
+        world->times[5] += stats_now() - start;
+
+        start = stats_now();
+        kept = world->spawners_count;
+        worldgen_spawners(world, band - 1);
+
+        spawners_labels = realloc(spawners_labels,
+            sizeof(int) * max(world->spawners_count, 1));
+
+        for (unsigned i = kept; i < world->spawners_count; i++)
+            spawners_labels[i] = base + regions_id(&regions,
+                (int) world->spawners[i].x, (int) world->spawners[i].y - first);
+
+        world->times[6] += stats_now() - start;
+
+        for (int layer = 0; layer < MAP_MAX_LAYERS; layer++) {
+            fseek(file, layers[layer] + (long) sizeof(tile_t) * width * first,
+                SEEK_SET);
+
+            for (int y = top; y < top + last - first; y++)
+                fwrite(world->map.tiles[layer][y], sizeof(tile_t), width, file);
+        }
+
+        start = stats_now();
+
+        for (int y = first; y < last && y <= center_y; y++) {
+            x = center_x - (center_y - y);
+
+            if (x >= 0 && regions_id(&regions, x, y - first) != REGIONS_NONE) {
+                walk.tiles[walk.count] = (Vector2) { x, y };
+                walk.labels[walk.count++] = base
+                    + regions_id(&regions, x, y - first);
+            }
+        }
+
+        world->times[7] += stats_now() - start;
+
+        regions_destroy(&regions);
+    }
+
+    start = stats_now();
+    largest = worldgen_largest(&labels);
+    world->times[5] += stats_now() - start;
+
+    // The spawners and the player, on the largest region, as the stages 6
+    // and 7 place them.
+    kept = 0;
+    for (unsigned i = 0; i < world->spawners_count; i++) {
+        if (largest != REGIONS_NONE
+                && regions_find(labels.parent, spawners_labels[i]) == largest)
+            world->spawners[kept++] = world->spawners[i];
+    }
+
+    world->spawners_count = kept;
+    world->player = (Vector2) { center_x, center_y };
+
+    if (largest != REGIONS_NONE) {
+        world->player = labels.firsts[largest];
+
+        // The closest tile to the center is the last one of the walk
+        for (unsigned i = 0; i < walk.count; i++) {
+            if (regions_find(labels.parent, walk.labels[i]) == largest)
+                world->player = walk.tiles[i];
+        }
+    }
+
+    fseek(file, spawners, SEEK_SET);
+    worldgen_write_spawners(file, world->spawners, world->spawners_count);
+    fprintf(file, ">Spawners\n");
+
+    fseek(file, player, SEEK_SET);
+    worldgen_write_player(file, world->player);
+
+    fseek(file, 0, SEEK_END);
+
+    free(labels.parent);
+    free(labels.sizes);
+    free(labels.firsts);
+    free(labels.above);
+
+    free(spawners_labels);
+    free(walk.tiles);
+    free(walk.labels);
+
+    return world->spawners_count;
+}
+
+static void worldgen_create_rows(worldgen_t *world, int width, int height,
+    unsigned seed, workers_t *workers, int first, int last)
+{
+    const int rows = last - first;
+
+    map_create(&world->map, width, rows);
+    world->map.seed = seed;
+    world->map.generator = WORLDGEN_VERSION;
+
+    world->height = height;
+    world->origin = first;
+
+    // The same stream that the game seeds with the world seed
+    random_seed(&world->random, seed, RANDOM_STREAM_WORLDGEN);
+    world->workers = workers;
+
+    world->player = (Vector2) { 0, 0 };
+    world->spawners = NULL;
+    world->spawners_count = 0;
+
+    world->regions.ids = NULL;
+    world->regions.sizes = NULL;
+    world->regions.count = 0;
+
+    world->samples = NULL;
+    world->samples_count = 0;
+
+    world->border_size = 5;
+
+    world->bitboard.current = world->bitboard.next = NULL;
+    world->bitboard.words = 0;
+
+    world->stage = 0;
+    world->steps = 0;
+    world->band = 0;
+    world->total = 0;
+    world->progress = 0;
+
+    world->above[0].samples = world->above[1].samples = NULL;
+    world->above[0].count = world->above[1].count = 0;
+
+    world->changed_first = rows;
+    world->changed_last = 0;
+
+    for (int stage = 0; stage < WORLDGEN_STAGES; stage++)
+        world->times[stage] = 0;
+}
+
+
+// The game rewrites each section in place, the player has all the fields
+// written by player_save(), with the values of a new player.
+static void worldgen_write_player(FILE *file, Vector2 position)
+{
+    const struct {
+        const char *name;
+        float       value;
+    } fields[] = {
+        { "Velocity", PLAYER_DEFAULT_VELOCITY },
+        { "Direction", 0 },
+        { "Hearts", PLAYER_DEFAULT_HEARTS },
+        { "MaxHearts", PLAYER_DEFAULT_HEARTS },
+        { "Attack", PLAYER_DEFAULT_ATTACK },
+        { "Defense", PLAYER_DEFAULT_DEFENSE },
+    };
+
+    fprintf(file, "<Player\n");
+
+    fprintf(file, "Position ");
+    fwrite(&position, sizeof(Vector2), 1, file);
+    fprintf(file, "\n");
+
+    for (unsigned i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        fprintf(file, "%s ", fields[i].name);
+        fwrite(&fields[i].value, sizeof(float), 1, file);
+        fprintf(file, "\n");
+    }
+
+    fprintf(file, ">Player\n");
+}
+
+// The entries of the spawners section, without its tags
+static void worldgen_write_spawners(FILE *file, const Vector2 *spawners,
+    unsigned count)
+{
+    const int spawn_min_entities = SPAWNER_DEFAULT_MIN_ENTITIES;
+    const int spawn_max_entities = SPAWNER_DEFAULT_MAX_ENTITIES;
+    const int spawn_radius = SPAWNER_DEFAULT_RADIUS;
+
+    for (unsigned i = 0; i < count; i++) {
+        fprintf(file, "Spawner ");
+        fwrite(&spawners[i], sizeof(Vector2), 1, file);
+        fwrite(&spawn_min_entities, sizeof(int), 1, file);
+        fwrite(&spawn_max_entities, sizeof(int), 1, file);
+        fwrite(&spawn_radius, sizeof(int), 1, file);
+        fprintf(file, "\n");
+    }
+}
+
+static void worldgen_changed(worldgen_t *world, int first_row, int last_row)
+{
+    world->changed_first = min(world->changed_first, first_row);
+    world->changed_last = max(world->changed_last, last_row);
+}
+
+static void worldgen_stage0(worldgen_t *world)
+{
+    random_t *random = &world->random;
+    worldgen_job_t job = { .world = world, .random = *random };
+
+    if (world->steps == 0)
+        world->steps = WORLDGEN_STEPS_STAGE0;
+
+    workers_run(world->workers, world->map.height, stage0_rows, &job);
+    worldgen_changed(world, 0, world->map.height);
+
+    // The rows of the world took the numbers of the stream in order, skip all
+    // of them and not only the ones of the map.
+    random_advance(random, (uint64_t) world->map.width * world->height);
+}
+
+static void worldgen_stage1(worldgen_t *world)
+{
+    uint64_t *swap;
+
+    worldgen_job_t job = { .world = world };
+
+    if (world->steps == 0) {
+        world->steps = WORLDGEN_STEPS_STAGE1;
+
+        world->bitboard.words = (world->map.width + 63) / 64;
+
+        world->bitboard.current = calloc((size_t) world->bitboard.words
+            * world->map.height, sizeof(uint64_t));
+        world->bitboard.next = calloc((size_t) world->bitboard.words
+            * world->map.height, sizeof(uint64_t));
+
+        workers_run(world->workers, world->map.height, stage1_pack, &job);
+    }
+
+    workers_run(world->workers, world->map.height, stage1_step, &job);
+
+    swap = world->bitboard.current;
+    world->bitboard.current = world->bitboard.next;
+    world->bitboard.next = swap;
+
+    // The tiles are only needed to draw the passes, and after the last one
+    workers_run(world->workers, world->map.height, stage1_unpack, &job);
+    worldgen_changed(world, 0, world->map.height);
+
+    if (world->steps == 1) {
+        free(world->bitboard.current);
+        free(world->bitboard.next);
+
+        world->bitboard.current = world->bitboard.next = NULL;
+    }
+}
+
+static void worldgen_stage2(worldgen_t *world)
+{
+    map_t next;
+    worldgen_job_t job = { .world = world, .next = &next };
+
+    if (world->steps == 0)
+        world->steps = WORLDGEN_STEPS_STAGE2;
+    else
+        // Only the first pass on this stage are needed, the others are for see
+        // the result.
+        return;
+
+    pthread_once(&g_worldgen.autotile_once, stage2_build_autotile);
+
+    map_create(&next, world->map.width, world->map.height);
+    next.seed = world->map.seed;
+    next.generator = world->map.generator;
+
+    workers_run(world->workers, world->map.height, stage2_rows, &job);
+
+    map_destroy(&world->map);
+    world->map = next;
+
+    worldgen_changed(world, 0, world->map.height);
+}
+
+static void worldgen_stage3(worldgen_t *world)
+{
+    random_t *random = &world->random;
+    worldgen_job_t job = { .world = world };
+
+    if (world->steps == 0)
+        world->steps = WORLDGEN_STEPS_STAGE3;
+
+    // The rules look at the decorations around each tile, the first pass copy
+    // them so all the bands see the layer as it was before this step.
+    job.layer = malloc(sizeof(tile_t *) * world->map.height);
+    job.layer[0] = malloc(sizeof(tile_t) * world->map.width * world->map.height);
+
+    for (int y = 1; y < world->map.height; y++)
+        job.layer[y] = job.layer[y - 1] + world->map.width;
+
+    workers_run(world->workers, world->map.height, stage3_copy, &job);
+
+    // Each row has its own stream, seeded by the row and by a seed of this step
+    job.seed = worldgen_seed(random);
+
+    workers_run(world->workers, world->map.height, stage3_rows, &job);
+    worldgen_changed(world, 0, world->map.height);
+
+    free(job.layer[0]);
+    free(job.layer);
+}
+
+// Each band is sampled around the trees of the band above, so the bands run in
+// order on a single thread. It's most of the time of a large world and what
+// keeps the generation from scaling with the workers.
+static void worldgen_stage4(worldgen_t *world)
+{
+    if (world->steps == 0) {
+        world->steps = worldgen_bands(world->height);
+        world->band = 0;
+
+        world->trees_seed = worldgen_seed(&world->random);
+    }
+
+    worldgen_trees(world, world->band++);
+}
+
+static void worldgen_stage5(worldgen_t *world)
+{
+    if (world->steps == 0)
+        world->steps = WORLDGEN_STEPS_STAGE5;
+
+    regions_create(&world->regions, &world->map, 0, world->map.height,
+        world->workers);
+}
+
+static void worldgen_stage6(worldgen_t *world)
+{
+    unsigned first = world->spawners_count;
+
+    if (world->steps == 0) {
+        world->steps = worldgen_bands(world->height);
+        world->band = 0;
+
+        world->spawners_seed = worldgen_seed(&world->random);
+    }
+
+    worldgen_spawners(world, world->band++);
+    stage6_reachable(world, first);
+}
+
+// The player walks to the top left from the center until it's on the largest
+// region, or stands on its first tile when the walk leaves the map.
+static void worldgen_stage7(worldgen_t *world)
+{
+    const int largest = regions_largest(&world->regions);
+    const int tiles = world->map.width * world->map.height;
+
+    Vector2 player_pos = (Vector2) {
+        .x = world->map.width / 2 - 1,
+        .y = world->map.height / 2 - 1,
+    };
+
+    int tile = 0;
+
+    if (world->steps == 0)
+        world->steps = WORLDGEN_STEPS_STAGE7;
+
+    world->player = player_pos;
+    if (largest == REGIONS_NONE)
+        return;
+
+    while (player_pos.x >= 0 && player_pos.y >= 0
+            && regions_id(&world->regions, (int) player_pos.x,
+                (int) player_pos.y) != largest) {
+        player_pos.x--;
+        player_pos.y--;
+    }
+
+    if (player_pos.x < 0 || player_pos.y < 0) {
+        while (tile < tiles && world->regions.ids[tile] != largest)
+            tile++;
+
+        player_pos.x = tile % world->map.width;
+        player_pos.y = tile / world->map.width;
+    }
+
+    world->player = player_pos;
+}
+
+static void stage0_rows(void *job, unsigned worker, unsigned first,
+    unsigned last)
+{
+    const uint32_t land = WORLDGEN_MAP_LAND_SPAWN_RATE * 4294967296.0;
+
+    worldgen_t *world = ((worldgen_job_t *) job)->world;
+    random_t random = ((worldgen_job_t *) job)->random;
+
+    uint32_t *values = malloc(sizeof(uint32_t) * world->map.width);
+
+    (void) worker;
+
+    // Start the band where a single thread would be at its first row
+    random_advance(&random, (uint64_t) (world->origin + first)
+        * world->map.width);
+
+    for (int y = first; y < (int) last; y++) {
+        random_fill(&random, values, world->map.width);
+
+        for (int x = 0; x < world->map.width; x++) {
+            world->map.tiles[0][y][x] = values[x] < land;
+            world->map.tiles[1][y][x] = 0;
+        }
+    }
+
+    free(values);
+}
+
+static void stage1_pack(void *job, unsigned worker, unsigned first,
+    unsigned last)
+{
+    worldgen_t *world = ((worldgen_job_t *) job)->world;
+    uint64_t *row;
+
+    (void) worker;
+
+    for (int y = first; y < (int) last; y++) {
+        row = world->bitboard.current + (size_t) y * world->bitboard.words;
+
+        for (int x = 0; x < world->map.width; x++)
+            if (world->map.tiles[0][y][x] != 0)
+                row[x / 64] |= (uint64_t) 1 << (x % 64);
+    }
+}
+
+static void stage1_unpack(void *job, unsigned worker, unsigned first,
+    unsigned last)
+{
+    worldgen_t *world = ((worldgen_job_t *) job)->world;
+    uint64_t *row;
+
+    (void) worker;
+
+    for (int y = first; y < (int) last; y++) {
+        row = world->bitboard.current + (size_t) y * world->bitboard.words;
+
+        for (int x = 0; x < world->map.width; x++)
+            world->map.tiles[0][y][x] = (row[x / 64] >> (x % 64)) & 1;
+    }
+}
+
+static void stage1_step(void *job, unsigned worker, unsigned first,
+    unsigned last)
+{
+// Bit sliced adders, each bit of the words is a different cell
+#define HALF_ADDER(sum, carry, a, b) do {                                      \
+    (sum) = (a) ^ (b);                                                         \
+    (carry) = (a) & (b);                                                       \
+} while (0)
+
+#define FULL_ADDER(sum, carry, a, b, c) do {                                   \
+    uint64_t partial = (a) ^ (b);                                              \
+                                                                               \
+    (sum) = partial ^ (c);                                                     \
+    (carry) = ((a) & (b)) | (partial & (c));                                   \
+} while (0)
+
+    worldgen_t *world = ((worldgen_job_t *) job)->world;
+
+    const int words = world->bitboard.words;
+    const int border = world->border_size;
+
+    // The last column that can be land, the original rule forces water when
+    // x > width - border, not >=
+    const int last_column = min(world->map.width - border, world->map.width - 1);
+
+    const uint64_t *rows[3];
+    uint64_t *next;
+
+    uint64_t cells[8];
+    uint64_t ones[3], twos[4], fours[2];
+    uint64_t bit0, bit1, bit2, bit3;
+
+    uint64_t border_mask, center, previous, following;
+    int first_x, last_x;
+
+    (void) worker;
+
+    // The halo are the rows of the current buffer, only the next is written
+    for (int y = first; y < (int) last; y++) {
+        next = world->bitboard.next + (size_t) y * words;
+
+        if (world->origin + y < border
+                || world->origin + y > world->height - border) {
+            for (int word = 0; word < words; word++)
+                next[word] = 0;
+
+            continue;
+        }
+
+        // Outside of the map its water, as the rows out of it
+        for (int row = 0; row < 3; row++)
+            rows[row] = y + row - 1 < 0 || y + row - 1 >= world->map.height ?
+                NULL : world->bitboard.current + (size_t) (y + row - 1) * words;
+
+        for (int word = 0; word < words; word++) {
+            // The three rows with the cells shifted to left and to right,
+            // taking the bits that cross the word from its neighbors.
+            for (int row = 0, cell = 0; row < 3; row++) {
+                center = previous = following = 0;
+
+                if (rows[row] != NULL) {
+                    center = rows[row][word];
+                    previous = word > 0 ? rows[row][word - 1] : 0;
+                    following = word + 1 < words ? rows[row][word + 1] : 0;
+                }
+
+                cells[cell++] = center << 1 | previous >> 63;
+                cells[cell++] = center >> 1 | following << 63;
+
+                // The center of the middle row is the cell itself
+                if (row != 1)
+                    cells[cell++] = center;
+            }
+
+            FULL_ADDER(ones[0], twos[0], cells[0], cells[1], cells[2]);
+            FULL_ADDER(ones[1], twos[1], cells[3], cells[4], cells[5]);
+            HALF_ADDER(ones[2], twos[2], cells[6], cells[7]);
+
+            FULL_ADDER(bit0, twos[3], ones[0], ones[1], ones[2]);
+
+            FULL_ADDER(ones[0], fours[0], twos[0], twos[1], twos[2]);
+            HALF_ADDER(bit1, fours[1], ones[0], twos[3]);
+
+            HALF_ADDER(bit2, bit3, fours[0], fours[1]);
+
+            first_x = max(border - word * 64, 0);
+            last_x = min(last_column - word * 64, 63);
+
+            border_mask = first_x > last_x ? 0
+                : (~(uint64_t) 0 >> (63 - last_x)) & (~(uint64_t) 0 << first_x);
+
+            // More than 4 neighbors is land and exactly 4 keeps the cell
+            next[word] = (bit3 | (bit2 & (bit1 | bit0))
+                | (~bit3 & bit2 & ~bit1 & ~bit0 & rows[1][word]))
+                & border_mask;
+        }
+    }
+
+#undef HALF_ADDER
+#undef FULL_ADDER
+}
+
+static void stage2_rows(void *job, unsigned worker, unsigned first,
+    unsigned last)
+{
+    worldgen_t *world = ((worldgen_job_t *) job)->world;
+    map_t *next = ((worldgen_job_t *) job)->next;
+
+    tile_t *rows[3];
+    int neighbors;
+
+    (void) worker;
+
+    for (int y = first; y < (int) last; y++) {
+        for (int x = 0; x < world->map.width; x++) {
+            if (world->map.tiles[0][y][x] != 0) {
+                next->tiles[0][y][x] = tile_new(11, 2);
+                continue;
+            }
+
+            // The edges have less neighbors, the bits of the ones that are
+            // out of the map are skipped.
+            if (x == 0 || y == 0 || x == world->map.width - 1
+                    || y == world->map.height - 1) {
+                neighbors = stage2_find_neighbors(&world->map, x, y);
+            } else {
+                rows[0] = world->map.tiles[0][y - 1];
+                rows[1] = world->map.tiles[0][y];
+                rows[2] = world->map.tiles[0][y + 1];
+
+                neighbors = (rows[0][x - 1] != 0) << 0
+                    | (rows[0][x + 0] != 0) << 1
+                    | (rows[0][x + 1] != 0) << 2
+                    | (rows[1][x - 1] != 0) << 3
+                    | (rows[1][x + 1] != 0) << 4
+                    | (rows[2][x - 1] != 0) << 5
+                    | (rows[2][x + 0] != 0) << 6
+                    | (rows[2][x + 1] != 0) << 7;
+            }
+
+            next->tiles[0][y][x] = g_worldgen.autotile[neighbors];
+        }
+    }
+}
+
+static void stage2_build_autotile(void)
+{
+    const unsigned rules = sizeof(g_autotile_rules)
+        / sizeof(g_autotile_rules[0]);
+
+    tile_t tile;
+
+    for (int neighbors = 0; neighbors < 256; neighbors++) {
+        tile = tile_new(9, 1);
+
+        for (unsigned rule = 0; rule < rules; rule++)
+            if ((neighbors & g_autotile_rules[rule].must_have)
+                        == g_autotile_rules[rule].must_have
+                    && !(neighbors & ~g_autotile_rules[rule].can_have))
+                tile = g_autotile_rules[rule].tile;
+
+        g_worldgen.autotile[neighbors] = tile_collidable(tile);
+    }
+
+}
+
+static int stage2_find_neighbors(map_t *map, int x, int y)
+{
+    int neighbors = 0;
+    int bit = 0;
+    int next_x, next_y;
+
+    for (int offset_y = -1; offset_y <= 1; offset_y++) {
+        next_y = y + offset_y;
+
+        for (int offset_x = -1; offset_x <= 1; offset_x++) {
+            next_x = x + offset_x;
+
+            if (next_x < 0 || next_y < 0 || next_x >= map->width
+                    || next_y >= map->height || (next_x == x && next_y == y))
+                continue;
+            else if (map->tiles[0][next_y][next_x] != 0)
+                neighbors |= 1 << bit;
+
+            bit++;
+        }
+    }
+
+    return neighbors;
+}
+
+static void stage3_copy(void *job, unsigned worker, unsigned first,
+    unsigned last)
+{
+    worldgen_t *world = ((worldgen_job_t *) job)->world;
+    tile_t **layer = ((worldgen_job_t *) job)->layer;
+
+    (void) worker;
+
+    for (int y = first; y < (int) last; y++)
+        memcpy(layer[y], world->map.tiles[1][y],
+            sizeof(tile_t) * world->map.width);
+}
+
+static void stage3_rows(void *job, unsigned worker, unsigned first,
+    unsigned last)
+{
+    worldgen_t *world = ((worldgen_job_t *) job)->world;
+    tile_t **layer = ((worldgen_job_t *) job)->layer;
+    uint64_t seed = ((worldgen_job_t *) job)->seed;
+
+    random_t random;
+
+    int type;
+    tile_t tile;
+
+    (void) worker;
+
+    for (int y = first; y < (int) last; y++) {
+        random_seed(&random, seed, world->origin + y);
+
+        for (int x = 0; x < world->map.width; x++) {
+            tile = 0;
+
+            if (!tile_empty(layer[y][x]))
+                continue;
+
+            if (tile_equal(world->map.tiles[0][y][x], tile_new(11, 2))) {
+                type = random_bounded(&random, 2);
+
+                if (random_double(&random) <= WORLDGEN_FLOWER_SPAWN_RATE)
+                    tile = tile_new(11, type);
+                else if (random_double(&random) <= WORLDGEN_GRAVESTONE_SPAWN_RATE
+                        && (stage3_count_neighbors(&world->map, layer, x, y,
+                                tile_new(11, 0)) > 2
+                            || stage3_count_neighbors(&world->map, layer, x, y,
+                                tile_new(11, 1)) > 3))
+                    tile = !stage3_count_neighbors(&world->map, layer, x, y,
+                        tile_new(1 - type, 2)) ?
+                        tile_collidable(tile_new(type, 2)) : 0;
+            } else if (tile_equal(world->map.tiles[0][y][x], tile_new(9, 1))) {
+                type = random_bounded(&random, 2);
+
+                if (random_double(&random) <= WORLDGEN_SINGLE_ROCK_SPAWN_RATE)
+                    tile = tile_new(type + 10, type + 3);
+                else if (random_double(&random) <= WORLDGEN_ROCKS_SPAWN_RATE
+                        && (stage3_count_neighbors(&world->map, layer, x, y,
+                                tile_new(10, 3))
+                            || stage3_count_neighbors(&world->map, layer, x, y,
+                                tile_new(11, 4))))
+                    tile = tile_new(11 - type, 3 + type);
+            }
+
+            if (!tile_empty(tile) && random_bounded(&random, 2))
+                tile = tile_flip(tile, 0);
+
+            world->map.tiles[1][y][x] = tile;
+        }
+    }
+}
+
+static int stage3_count_neighbors(map_t *map, tile_t **layer, int x, int y,
+    tile_t tile)
+{
+    int next_x, next_y;
+    int neighbors = 0;
+
+    for (int offset_y = -1; offset_y <= 1; offset_y++) {
+        next_y = y + offset_y;
+
+        for (int offset_x = -1; offset_x <= 1; offset_x++) {
+            next_x = x + offset_x;
+
+            if (next_x < 0 || next_y < 0 || next_x >= map->width
+                    || next_y >= map->height || (next_x == x && next_y == y))
+                continue;
+            else if (tile_equal(layer[next_y][next_x], tile))
+                neighbors++;
+        }
+    }
+
+    return neighbors;
+}
+
+/* The trees and the spawners are placed on bands of rows, from the top:
+ *
+ *   Each band has its own stream and its samples are only kept apart from the
+ * ones of the band above, so a band only needs the rows of the one above to be
+ * placed. It's the same on the whole map and on the streaming generator, that
+ * only has those bands.
+ */
+static void worldgen_trees(worldgen_t *world, int band)
+{
+    const int first = band * WORLDGEN_BAND_ROWS;
+    const int rows = min(WORLDGEN_BAND_ROWS, world->height - first);
+
+    // First row of the band on the map
+    const int top = first - world->origin;
+
+    random_t random;
+    bool *mask = malloc(sizeof(bool) * world->map.width * rows);
+    bool floor;
+
+    int floors_count = 0;
+    int trees;
+
+    random_seed(&random, world->trees_seed, band);
+
+    // The trees are two tiles high, the top one can be over anything
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < world->map.width; x++) {
+            floor = tile_equal(world->map.tiles[0][top + y][x],
+                tile_new(11, 2));
+
+            mask[y * world->map.width + x] = floor && first + y > 0;
+            floors_count += floor;
+        }
+    }
+
+    worldgen_sample(world, &random, mask, first, rows, WORLDGEN_TREE_DISTANCE,
+        WORLDGEN_ABOVE_TREES);
+    free(mask);
+
+    trees = min(floors_count * WORLDGEN_TREE_GENERATION_FACTOR,
+        world->samples_count);
+
+    for (int tree = 0; tree < trees; tree++)
+        stage4_place_tree(world, &random);
+}
+
+static void worldgen_spawners(worldgen_t *world, int band)
+{
+    const int first = band * WORLDGEN_BAND_ROWS;
+    const int rows = min(WORLDGEN_BAND_ROWS, world->height - first);
+    const int top = first - world->origin;
+
+    random_t random;
+    bool *mask = malloc(sizeof(bool) * world->map.width * rows);
+
+    random_seed(&random, world->spawners_seed, band);
+
+    for (int y = 0; y < rows; y++)
+        for (int x = 0; x < world->map.width; x++)
+            mask[y * world->map.width + x] =
+                !tile_collision(world->map.tiles[0][top + y][x])
+                && !tile_collision(world->map.tiles[1][top + y][x]);
+
+    worldgen_sample(world, &random, mask, first, rows,
+        SPAWNER_DISTANCE_RADIUS, WORLDGEN_ABOVE_SPAWNERS);
+    free(mask);
+
+    world->spawners = realloc(world->spawners,
+        sizeof(Vector2) * (world->spawners_count + world->samples_count));
+
+    // All the samples of the band, in a random order
+    while (world->samples_count > 0)
+        stage6_place_spawner(world, &random);
+}
+
+static void stage4_place_tree(worldgen_t *world, random_t *random)
+{
+    unsigned sample = random_bounded(random, world->samples_count);
+
+    int tree_x = world->samples[sample].x;
+    int tree_y = world->samples[sample].y - world->origin;
+
+    int tree_type = random_bounded(random, 2);
+
+    // The samples are in the order they grew, the trees are taken at random so
+    // they spread over all the band.
+    world->samples[sample] = world->samples[--world->samples_count];
+
+    world->map.tiles[1][tree_y - 0][tree_x] = tile_collidable(tile_new(tree_type, 4));
+    world->map.tiles[1][tree_y - 1][tree_x] = tile_new(tree_type, 3);
+
+    worldgen_changed(world, tree_y - 1, tree_y + 1);
+}
+
+static void stage6_place_spawner(worldgen_t *world, random_t *random)
+{
+    unsigned sample = random_bounded(random, world->samples_count);
+
+    world->spawners[world->spawners_count++] = world->samples[sample];
+    world->samples[sample] = world->samples[--world->samples_count];
+}
+
+// Keep only the spawners, from the first one, that are on the largest region
+static void stage6_reachable(worldgen_t *world, unsigned first)
+{
+    const int largest = regions_largest(&world->regions);
+    unsigned kept = first;
+
+    for (unsigned i = first; i < world->spawners_count; i++) {
+        if (regions_id(&world->regions, (int) world->spawners[i].x,
+                (int) world->spawners[i].y) == largest)
+            world->spawners[kept++] = world->spawners[i];
+    }
+
+    world->spawners_count = kept;
+}
+
+static void worldgen_sample(worldgen_t *world, random_t *random, bool *mask,
+    int first, int rows, float radius, int above)
+{
+    Vector2 *fixed = malloc(sizeof(Vector2)
+        * max(world->above[above].count, 1));
+    unsigned fixed_count = 0;
+
+    // The samples of the band above, relative to this one
+    for (unsigned i = 0; i < world->above[above].count; i++) {
+        fixed[fixed_count] = world->above[above].samples[i];
+        fixed[fixed_count++].y -= first;
+    }
+
+    free(world->samples);
+
+    world->samples_count = poisson_sample_around(random, mask,
+        world->map.width, rows, radius, fixed, fixed_count, &world->samples);
+
+    free(fixed);
+
+    for (unsigned i = 0; i < world->samples_count; i++)
+        world->samples[i].y += first;
+
+    // They're taken from the samples, the band below needs all of them
+    world->above[above].samples = realloc(world->above[above].samples,
+        sizeof(Vector2) * max(world->samples_count, 1));
+    world->above[above].count = world->samples_count;
+
+    memcpy(world->above[above].samples, world->samples,
+        sizeof(Vector2) * world->samples_count);
+}
+
+static uint64_t worldgen_seed(random_t *random)
+{
+    uint64_t seed = (uint64_t) random_next(random) << 32;
+
+    return seed | random_next(random);
+}
+
+// Add the regions of a band, that starts on the row first, and join them with
+// the ones of the band above. The label of the first region is returned.
+static int worldgen_join(worldgen_labels_t *labels, regions_t *regions,
+    int first)
+{
+    const int base = labels->count;
+    const int width = regions->width;
+
+    unsigned next = 0;
+
+    if (labels->count + regions->count > labels->capacity) {
+        labels->capacity = max(labels->capacity * 2,
+            labels->count + regions->count);
+
+        labels->parent = realloc(labels->parent,
+            sizeof(int) * labels->capacity);
+        labels->sizes = realloc(labels->sizes,
+            sizeof(unsigned) * labels->capacity);
+        labels->firsts = realloc(labels->firsts,
+            sizeof(Vector2) * labels->capacity);
+    }
+
+    for (unsigned region = 0; region < regions->count; region++) {
+        labels->parent[base + region] = base + region;
+        labels->sizes[base + region] = regions->sizes[region];
+    }
+
+    // The regions are numbered in the order of their first tile
+    for (int i = 0; next < regions->count; i++) {
+        if (regions->ids[i] == (int) next)
+            labels->firsts[base + next++] = (Vector2) {
+                i % width, first + i / width
+            };
+    }
+
+    for (int x = 0; x < width; x++) {
+        if (labels->above[x] != REGIONS_NONE
+                && regions->ids[x] != REGIONS_NONE)
+            regions_union(labels->parent, labels->above[x],
+                base + regions->ids[x]);
+
+        labels->above[x] = regions_id(regions, x, regions->height - 1);
+        if (labels->above[x] != REGIONS_NONE)
+            labels->above[x] += base;
+    }
+
+    labels->count += regions->count;
+
+    return base;
+}
+
+// Root of the largest region, the first one of them on a tie, as
+// regions_largest()
+static int worldgen_largest(worldgen_labels_t *labels)
+{
+    int largest = REGIONS_NONE;
+    int root;
+
+    // The roots are before the other labels of their regions
+    for (unsigned label = 0; label < labels->count; label++) {
+        root = regions_find(labels->parent, label);
+
+        if (root != (int) label)
+            labels->sizes[root] += labels->sizes[label];
+    }
+
+    for (unsigned label = 0; label < labels->count; label++) {
+        if (labels->parent[label] == (int) label && (largest == REGIONS_NONE
+                || labels->sizes[label] > labels->sizes[largest]))
+            largest = label;
+    }
+
+    return largest;
+}